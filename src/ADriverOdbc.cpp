@@ -15,10 +15,11 @@
 #include <QJsonObject>
 #include <QJsonValue>
 #include <QLoggingCategory>
-#include <QMutexLocker>
 #include <QTimeZone>
 #include <QUuid>
 
+#include <cctype>
+
 Q_LOGGING_CATEGORY(ASQL_ODBC, "asql.odbc", QtInfoMsg)
 
 using namespace Qt::StringLiterals;
@@ -45,6 +46,39 @@ QString extractConnString(const QString &connInfo)
     return connInfo;
 }
 
+/*!
+ * \brief Returns whether a transaction is open after \p query ran, or nothing if it
+ * doesn't begin or end one. ODBC only reports transactions controlled with
+ * SQL_ATTR_AUTOCOMMIT, so the ones begun with SQL are tracked from the statement text.
+ */
+std::optional<bool> transactionState(QByteArrayView query)
+{
+    query          = query.trimmed();
+    qsizetype size = 0;
+    while (size < query.size() && std::isalpha(static_cast<unsigned char>(query[size]))) {
+        ++size;
+    }
+
+    const QByteArrayView keyword = query.first(size);
+    auto is                      = [keyword](QByteArrayView word) {
+        return keyword.compare(word, Qt::CaseInsensitive) == 0;
+    };
+
+    if (is("BEGIN") || is("START")) {
+        return true;
+    } else if (is("COMMIT") || is("END")) {
+        return false;
+    } else if (is("ROLLBACK")) {
+        // ROLLBACK TO SAVEPOINT keeps the transaction open
+        const QByteArrayView rest = query.sliced(size).trimmed();
+        if (rest.size() >= 2 && rest.first(2).compare("TO", Qt::CaseInsensitive) == 0) {
+            return {};
+        }
+        return false;
+    }
+    return {};
+}
+
 } // namespace
 
 // ─────────────────────────────── AOdbcThread ──────────────────────────────────
@@ -99,6 +133,14 @@ QString AOdbcThread::odbcError(SQLSMALLINT handleType, SQLHANDLE handle)
     return result;
 }
 
+void AOdbcThread::enqueueAndSignal(OdbcQueryPromise &promise)
+{
+    // Only the first result since the owner thread last drained the queue wakes it up
+    if (m_promisesReady.push(std::move(promise))) {
+        Q_EMIT queryReady();
+    }
+}
+
 void AOdbcThread::open()
 {
     const QString dsn = extractConnString(m_connString);
@@ -211,7 +253,14 @@ QString AOdbcThread::readWCharColumn(SQLHSTMT stmt, SQLUSMALLINT col)
     return result;
 }
 
-QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT sqlType)
+/*!
+ * \brief Appends the value of \p col of the current row to \p data, fetched with the C type
+ * of its \p sqlType so numbers, binaries and dates are stored without building a QVariant.
+ */
+void AOdbcThread::appendColumn(SQLHSTMT stmt,
+                               SQLUSMALLINT col,
+                               SQLSMALLINT sqlType,
+                               AColumnarData &data)
 {
     SQLLEN indicator = 0;
 
@@ -221,9 +270,11 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
         SQLCHAR val   = 0;
         SQLRETURN ret = SQLGetData(stmt, col, SQL_C_BIT, &val, sizeof(val), &indicator);
         if (ret == SQL_ERROR || indicator == SQL_NULL_DATA) {
-            return QVariant(QMetaType::fromType<bool>());
+            data.appendNull(QMetaType::fromType<bool>());
+        } else {
+            data.appendBool(val != 0);
         }
-        return val != 0;
+        break;
     }
 
     case SQL_TINYINT:
@@ -231,9 +282,11 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
         SQLSCHAR val  = 0;
         SQLRETURN ret = SQLGetData(stmt, col, SQL_C_STINYINT, &val, sizeof(val), &indicator);
         if (ret == SQL_ERROR || indicator == SQL_NULL_DATA) {
-            return QVariant(QMetaType::fromType<int>());
+            data.appendNull(QMetaType::fromType<int>());
+        } else {
+            data.appendInt(val, QMetaType::fromType<int>());
         }
-        return static_cast<int>(val);
+        break;
     }
 
     case SQL_SMALLINT:
@@ -241,9 +294,11 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
         SQLSMALLINT val = 0;
         SQLRETURN ret   = SQLGetData(stmt, col, SQL_C_SSHORT, &val, sizeof(val), &indicator);
         if (ret == SQL_ERROR || indicator == SQL_NULL_DATA) {
-            return QVariant(QMetaType::fromType<int>());
+            data.appendNull(QMetaType::fromType<int>());
+        } else {
+            data.appendInt(val, QMetaType::fromType<int>());
         }
-        return static_cast<int>(val);
+        break;
     }
 
     case SQL_INTEGER:
@@ -251,9 +306,11 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
         SQLINTEGER val = 0;
         SQLRETURN ret  = SQLGetData(stmt, col, SQL_C_SLONG, &val, sizeof(val), &indicator);
         if (ret == SQL_ERROR || indicator == SQL_NULL_DATA) {
-            return QVariant(QMetaType::fromType<int>());
+            data.appendNull(QMetaType::fromType<int>());
+        } else {
+            data.appendInt(val, QMetaType::fromType<int>());
         }
-        return static_cast<int>(val);
+        break;
     }
 
     case SQL_BIGINT:
@@ -261,9 +318,11 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
         SQLBIGINT val = 0;
         SQLRETURN ret = SQLGetData(stmt, col, SQL_C_SBIGINT, &val, sizeof(val), &indicator);
         if (ret == SQL_ERROR || indicator == SQL_NULL_DATA) {
-            return QVariant(QMetaType::fromType<qint64>());
+            data.appendNull(QMetaType::fromType<qint64>());
+        } else {
+            data.appendInt(val);
         }
-        return static_cast<qint64>(val);
+        break;
     }
 
     case SQL_REAL:
@@ -271,9 +330,11 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
         SQLREAL val   = 0;
         SQLRETURN ret = SQLGetData(stmt, col, SQL_C_FLOAT, &val, sizeof(val), &indicator);
         if (ret == SQL_ERROR || indicator == SQL_NULL_DATA) {
-            return QVariant(QMetaType::fromType<double>());
+            data.appendNull(QMetaType::fromType<double>());
+        } else {
+            data.appendDouble(val);
         }
-        return static_cast<double>(val);
+        break;
     }
 
     case SQL_FLOAT:
@@ -282,9 +343,11 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
         SQLDOUBLE val = 0;
         SQLRETURN ret = SQLGetData(stmt, col, SQL_C_DOUBLE, &val, sizeof(val), &indicator);
         if (ret == SQL_ERROR || indicator == SQL_NULL_DATA) {
-            return QVariant(QMetaType::fromType<double>());
+            data.appendNull(QMetaType::fromType<double>());
+        } else {
+            data.appendDouble(val);
         }
-        return static_cast<double>(val);
+        break;
     }
 
     case SQL_BINARY:
@@ -302,7 +365,8 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
                 break;
             }
             if (indicator == SQL_NULL_DATA) {
-                return QVariant(QMetaType::fromType<QByteArray>());
+                data.appendNull(QMetaType::fromType<QByteArray>());
+                return;
             }
             // When SQL_SUCCESS_WITH_INFO the full CHUNK was written and more data remains.
             // When SQL_SUCCESS, indicator holds the byte count actually written.
@@ -311,7 +375,8 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
                                    : (indicator > 0 ? qMin(indicator, CHUNK) : 0);
             result.append(chunk.constData(), static_cast<qsizetype>(got));
         } while (ret == SQL_SUCCESS_WITH_INFO);
-        return result;
+        data.appendBytes(result);
+        break;
     }
 
     case SQL_TYPE_DATE:
@@ -319,9 +384,11 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
         DATE_STRUCT ds{};
         SQLRETURN ret = SQLGetData(stmt, col, SQL_C_TYPE_DATE, &ds, sizeof(ds), &indicator);
         if (ret == SQL_ERROR || indicator == SQL_NULL_DATA) {
-            return QVariant(QMetaType::fromType<QDate>());
+            data.appendNull(QMetaType::fromType<QDate>());
+        } else {
+            data.appendDate(QDate(ds.year, ds.month, ds.day));
         }
-        return QDate(ds.year, ds.month, ds.day);
+        break;
     }
 
 #ifdef HAVE_MSODBCSQL_H
@@ -331,9 +398,12 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
         SQL_SS_TIME2_STRUCT ts{};
         SQLRETURN ret = SQLGetData(stmt, col, SQL_C_SS_TIME2, &ts, sizeof(ts), &indicator);
         if (ret == SQL_ERROR || indicator == SQL_NULL_DATA) {
-            return QVariant(QMetaType::fromType<QTime>());
+            data.appendNull(QMetaType::fromType<QTime>());
+        } else {
+            data.appendTime(
+                QTime(ts.hour, ts.minute, ts.second, static_cast<int>(ts.fraction / 1000000)));
         }
-        return QTime(ts.hour, ts.minute, ts.second, static_cast<int>(ts.fraction / 1000000));
+        break;
     }
 #endif
 
@@ -342,9 +412,11 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
         TIME_STRUCT ts{};
         SQLRETURN ret = SQLGetData(stmt, col, SQL_C_TYPE_TIME, &ts, sizeof(ts), &indicator);
         if (ret == SQL_ERROR || indicator == SQL_NULL_DATA) {
-            return QVariant(QMetaType::fromType<QTime>());
+            data.appendNull(QMetaType::fromType<QTime>());
+        } else {
+            data.appendTime(QTime(ts.hour, ts.minute, ts.second));
         }
-        return QTime(ts.hour, ts.minute, ts.second);
+        break;
     }
 
     case SQL_TYPE_TIMESTAMP:
@@ -352,7 +424,8 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
         TIMESTAMP_STRUCT tss{};
         SQLRETURN ret = SQLGetData(stmt, col, SQL_C_TYPE_TIMESTAMP, &tss, sizeof(tss), &indicator);
         if (ret == SQL_ERROR || indicator == SQL_NULL_DATA) {
-            return QVariant(QMetaType::fromType<QDateTime>());
+            data.appendNull(QMetaType::fromType<QDateTime>());
+            break;
         }
         const QDate date(tss.year, tss.month, tss.day);
         const QTime time(
@@ -360,7 +433,9 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
         // SQL_TYPE_TIMESTAMP (datetime/datetime2) carries no timezone info.
         // Use Qt::LocalTime to match QSql ODBC behaviour: the value is returned as-is
         // without any UTC offset, so toString() won't append "Z".
-        return QDateTime(date, time, QTimeZone::LocalTime);
+        // AColumnarData has no typed date time storage, these are kept as QVariant
+        data.append(QDateTime(date, time, QTimeZone::LocalTime));
+        break;
     }
 
     default:
@@ -368,13 +443,23 @@ QVariant AOdbcThread::columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT s
         {
             const QString str = readWCharColumn(stmt, col);
             if (str.isNull()) {
-                return QVariant(QMetaType::fromType<QString>());
+                data.appendNull(QMetaType::fromType<QString>());
+            } else {
+                data.appendText(str.toUtf8());
             }
-            return str;
         }
     }
 }
 
+/*!
+ * \brief Pool threads never get an interruption request, so closing is also flagged
+ */
+bool AOdbcThread::interrupted() const
+{
+    return m_closing.load(std::memory_order_relaxed) ||
+           QThread::currentThread()->isInterruptionRequested();
+}
+
 void AOdbcThread::fetchResults(SQLHSTMT stmt, OdbcQueryPromise &promise)
 {
     SQLSMALLINT numCols = 0;
@@ -387,6 +472,7 @@ void AOdbcThread::fetchResults(SQLHSTMT stmt, OdbcQueryPromise &promise)
 
     // Fetch column names and types
     QVector<SQLSMALLINT> colTypes(numCols);
+    promise.result->m_data.reset(numCols);
     for (SQLSMALLINT i = 1; i <= numCols; ++i) {
         SQLWCHAR colName[256];
         SQLSMALLINT colNameLen = 0;
@@ -416,7 +502,7 @@ void AOdbcThread::fetchResults(SQLHSTMT stmt, OdbcQueryPromise &promise)
 
     // Fetch rows
     while (true) {
-        if (QThread::currentThread()->isInterruptionRequested()) {
+        if (interrupted()) {
             promise.result->m_error = u"Interrupt requested"_s;
             return;
         }
@@ -431,10 +517,11 @@ void AOdbcThread::fetchResults(SQLHSTMT stmt, OdbcQueryPromise &promise)
         }
 
         for (SQLSMALLINT i = 0; i < numCols; ++i) {
-            promise.result->m_rows
-                << columnValue(stmt, static_cast<SQLUSMALLINT>(i + 1), colTypes[i]);
+            appendColumn(
+                stmt, static_cast<SQLUSMALLINT>(i + 1), colTypes[i], promise.result->m_data);
         }
     }
+    promise.result->m_data.squeeze();
 
     // Get the number of affected rows
     SQLLEN rowCount = 0;
@@ -670,13 +757,7 @@ void AOdbcThread::bindParameters(SQLHSTMT stmt,
 
 void AOdbcThread::query(OdbcQueryPromise promise)
 {
-    auto _ = qScopeGuard([&] {
-        {
-            QMutexLocker _(&m_promisesMutex);
-            m_promisesReady.enqueue(std::move(promise));
-        }
-        Q_EMIT queryReady();
-    });
+    auto _ = qScopeGuard([&] { enqueueAndSignal(promise); });
 
     SQLHSTMT stmt = SQL_NULL_HSTMT;
     SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, m_dbc, &stmt);
@@ -714,18 +795,16 @@ void AOdbcThread::query(OdbcQueryPromise promise)
         return;
     }
 
+    if (const auto state = transactionState(promise.result->m_query)) {
+        m_inTransaction = *state;
+    }
+
     fetchResults(stmt, promise);
 }
 
 void AOdbcThread::queryPrepared(OdbcQueryPromise promise)
 {
-    auto _ = qScopeGuard([&] {
-        {
-            QMutexLocker _(&m_promisesMutex);
-            m_promisesReady.enqueue(std::move(promise));
-        }
-        Q_EMIT queryReady();
-    });
+    auto _ = qScopeGuard([&] { enqueueAndSignal(promise); });
 
     const int queryId = promise.preparedQuery->identification();
 
@@ -788,16 +867,151 @@ void AOdbcThread::queryPrepared(OdbcQueryPromise promise)
     SQLCloseCursor(stmt);
 }
 
-void AOdbcThread::queryExec(OdbcQueryPromise promise)
+/*!
+ * \brief Executes the statement once for each row of parameters in a single transaction.
+ *
+ * The statement is prepared once and the rows run with auto commit disabled so that
+ * the batch is applied or rolled back as a whole with SQLEndTran(). When a transaction
+ * begun with SQL is open a savepoint is used instead, ending the transaction would
+ * commit or roll back the caller's work.
+ */
+void AOdbcThread::queryBatch(OdbcQueryPromise promise)
 {
-    auto _ = qScopeGuard([&] {
-        {
-            QMutexLocker _(&m_promisesMutex);
-            m_promisesReady.enqueue(std::move(promise));
+    auto _ = qScopeGuard([&] { enqueueAndSignal(promise); });
+
+    SQLHSTMT stmt = SQL_NULL_HSTMT;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, m_dbc, &stmt);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+        promise.result->m_error =
+            u"Failed to allocate statement handle: "_s + odbcError(SQL_HANDLE_DBC, m_dbc);
+        return;
+    }
+
+    auto stmtGuard = qScopeGuard([&] { SQLFreeHandle(SQL_HANDLE_STMT, stmt); });
+
+    const QString queryStr = QString::fromUtf8(promise.result->m_query);
+    ret                    = SQLPrepareW(
+        stmt, reinterpret_cast<SQLWCHAR *>(const_cast<QChar *>(queryStr.unicode())), SQL_NTS);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+        promise.result->m_error =
+            u"Failed to prepare statement: "_s + odbcError(SQL_HANDLE_STMT, stmt);
+        return;
+    }
+
+    const bool inTransaction = m_inTransaction;
+    if (inTransaction) {
+        if (auto error = execDirect(u"SAVEPOINT asql_batch")) {
+            promise.result->m_error = u"Failed to begin batch: "_s + *error;
+            return;
+        }
+    } else {
+        ret = SQLSetConnectAttr(m_dbc,
+                                SQL_ATTR_AUTOCOMMIT,
+                                reinterpret_cast<SQLPOINTER>(SQL_AUTOCOMMIT_OFF),
+                                SQL_IS_UINTEGER);
+        if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+            promise.result->m_error =
+                u"Failed to begin batch: "_s + odbcError(SQL_HANDLE_DBC, m_dbc);
+            return;
+        }
+    }
+
+    auto autoCommitGuard = qScopeGuard([&] {
+        if (!inTransaction) {
+            SQLSetConnectAttr(m_dbc,
+                              SQL_ATTR_AUTOCOMMIT,
+                              reinterpret_cast<SQLPOINTER>(SQL_AUTOCOMMIT_ON),
+                              SQL_IS_UINTEGER);
         }
-        Q_EMIT queryReady();
     });
 
+    qint64 changes                  = 0;
+    const QList<QVariantList> &rows = promise.batch;
+    for (qsizetype i = 0; i < rows.size(); ++i) {
+        if (interrupted()) {
+            promise.result->m_error = u"Interrupt requested"_s;
+            break;
+        }
+
+        SQLFreeStmt(stmt, SQL_RESET_PARAMS);
+
+        QList<QByteArray> buffers;
+        QList<SQLLEN> indicators;
+        bindParameters(stmt, rows.at(i), promise, buffers, indicators);
+        if (promise.result->m_error.has_value()) {
+            promise.result->m_error =
+                u"Failed to bind row %1: %2"_s.arg(QString::number(i), *promise.result->m_error);
+            break;
+        }
+
+        // SQL_NO_DATA means an UPDATE or DELETE that didn't match any row
+        ret = SQLExecute(stmt);
+        if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO && ret != SQL_NO_DATA) {
+            promise.result->m_error = u"Failed to execute row %1: "_s.arg(QString::number(i)) +
+                                      odbcError(SQL_HANDLE_STMT, stmt);
+            break;
+        }
+
+        SQLLEN rowCount = 0;
+        SQLRowCount(stmt, &rowCount);
+        if (rowCount > 0) {
+            changes += static_cast<qint64>(rowCount);
+        }
+
+        // Rows returned by the statement are discarded
+        SQLFreeStmt(stmt, SQL_CLOSE);
+    }
+
+    if (!promise.result->m_error && inTransaction) {
+        if (auto error = execDirect(u"RELEASE SAVEPOINT asql_batch")) {
+            promise.result->m_error = u"Failed to commit batch: "_s + *error;
+        }
+    } else if (!promise.result->m_error) {
+        ret = SQLEndTran(SQL_HANDLE_DBC, m_dbc, SQL_COMMIT);
+        if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+            promise.result->m_error =
+                u"Failed to commit batch: "_s + odbcError(SQL_HANDLE_DBC, m_dbc);
+        }
+    }
+
+    if (promise.result->m_error) {
+        if (inTransaction) {
+            execDirect(u"ROLLBACK TO SAVEPOINT asql_batch");
+            execDirect(u"RELEASE SAVEPOINT asql_batch");
+        } else {
+            SQLEndTran(SQL_HANDLE_DBC, m_dbc, SQL_ROLLBACK);
+        }
+        return;
+    }
+
+    promise.result->m_numRowsAffected = changes;
+}
+
+/*!
+ * \brief Runs \p query discarding its results, returning the error if it fails
+ */
+std::optional<QString> AOdbcThread::execDirect(QStringView query)
+{
+    SQLHSTMT stmt = SQL_NULL_HSTMT;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, m_dbc, &stmt);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+        return odbcError(SQL_HANDLE_DBC, m_dbc);
+    }
+
+    auto stmtGuard         = qScopeGuard([&] { SQLFreeHandle(SQL_HANDLE_STMT, stmt); });
+    const QString queryStr = query.toString();
+    ret                    = SQLExecDirectW(
+        stmt, reinterpret_cast<SQLWCHAR *>(const_cast<QChar *>(queryStr.unicode())), SQL_NTS);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO && ret != SQL_NO_DATA) {
+        return odbcError(SQL_HANDLE_STMT, stmt);
+    }
+    return {};
+}
+
+void AOdbcThread::queryExec(OdbcQueryPromise promise)
+{
+    auto _ = qScopeGuard([&] { enqueueAndSignal(promise); });
+
     SQLHSTMT stmt = SQL_NULL_HSTMT;
     SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, m_dbc, &stmt);
     if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
@@ -817,22 +1031,30 @@ void AOdbcThread::queryExec(OdbcQueryPromise promise)
         return;
     }
 
+    if (const auto state = transactionState(promise.result->m_query)) {
+        m_inTransaction = *state;
+    }
+
     fetchResults(stmt, promise);
 }
 
 // ─────────────────────────────── ADriverOdbc ──────────────────────────────────
 
-ADriverOdbc::ADriverOdbc(const QString &connInfo)
+ADriverOdbc::ADriverOdbc(const QString &connInfo, QThreadPool *pool)
     : ADriver{connInfo}
     , m_worker{connInfo}
 {
-    m_thread.setObjectName(connInfo);
-    m_worker.moveToThread(&m_thread);
+    if (pool) {
+        m_strand = std::make_unique<AStrand>(pool);
+    } else {
+        m_thread.setObjectName(connInfo);
+        m_worker.moveToThread(&m_thread);
+    }
 
     connect(&m_worker, &AOdbcThread::queryReady, this, [this] {
-        QMutexLocker _(&m_worker.m_promisesMutex);
-        while (!m_worker.m_promisesReady.isEmpty()) {
-            OdbcQueryPromise promise = m_worker.m_promisesReady.dequeue();
+        m_worker.m_promisesReady.wakeupReceived();
+        while (auto ready = m_worker.m_promisesReady.pop()) {
+            OdbcQueryPromise promise = std::move(*ready);
             if (!promise.receiver.has_value() || !promise.receiver->isNull()) {
                 if (promise.cb) {
                     AResult result{promise.result};
@@ -846,18 +1068,38 @@ ADriverOdbc::ADriverOdbc(const QString &connInfo)
         }
     }, Qt::QueuedConnection);
 
-    m_thread.start();
+    if (!m_strand) {
+        m_thread.start();
+    }
 }
 
 ADriverOdbc::~ADriverOdbc()
 {
     Q_ASSERT(m_thread.thread() == QThread::currentThread());
 
+    // Queued tasks are dropped as with the thread, but the running one must finish
+    m_worker.m_closing = true;
+    m_strand.reset();
+
     m_thread.requestInterruption();
     m_thread.quit();
     m_thread.wait();
 }
 
+template <typename Method, typename... Args>
+void ADriverOdbc::dispatch(Method method, Args... args)
+{
+    auto task = [worker = &m_worker, method, ... args = std::move(args)]() mutable {
+        (worker->*method)(std::move(args)...);
+    };
+
+    if (m_strand) {
+        m_strand->post(std::move(task));
+    } else {
+        QMetaObject::invokeMethod(&m_worker, std::move(task), Qt::QueuedConnection);
+    }
+}
+
 QString ADriverOdbc::driverName() const
 {
     return u"odbc"_s;
@@ -907,11 +1149,7 @@ void ADriverOdbc::open(const std::shared_ptr<ADriver> &driver, QObject *receiver
         }
     }, Qt::SingleShotConnection);
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(&m_worker, &AOdbcThread::open, Qt::QueuedConnection);
-#else
-    QMetaObject::invokeMethod(&m_worker, "open", Qt::QueuedConnection);
-#endif
+    dispatch(&AOdbcThread::open);
 }
 
 bool ADriverOdbc::isOpen() const
@@ -974,15 +1212,7 @@ void ADriverOdbc::exec(const std::shared_ptr<ADriver> &db,
     }
     data.result->m_query.setRawData(query.data(), query.size());
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &AOdbcThread::queryExec, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(&m_worker,
-                              "queryExec",
-                              Qt::QueuedConnection,
-                              Q_ARG(ASql::OdbcQueryPromise, std::move(data)));
-#endif
+    dispatch(&AOdbcThread::queryExec, std::move(data));
 }
 
 void ADriverOdbc::exec(const std::shared_ptr<ADriver> &db,
@@ -1002,15 +1232,7 @@ void ADriverOdbc::exec(const std::shared_ptr<ADriver> &db,
     }
     data.result->m_query = query.toUtf8();
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &AOdbcThread::queryExec, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(&m_worker,
-                              "queryExec",
-                              Qt::QueuedConnection,
-                              Q_ARG(ASql::OdbcQueryPromise, std::move(data)));
-#endif
+    dispatch(&AOdbcThread::queryExec, std::move(data));
 }
 
 void ADriverOdbc::exec(const std::shared_ptr<ADriver> &db,
@@ -1032,13 +1254,7 @@ void ADriverOdbc::exec(const std::shared_ptr<ADriver> &db,
     data.result->m_query.setRawData(query.data(), query.size());
     data.result->m_queryArgs = params;
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &AOdbcThread::query, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(
-        &m_worker, "query", Qt::QueuedConnection, Q_ARG(ASql::OdbcQueryPromise, std::move(data)));
-#endif
+    dispatch(&AOdbcThread::query, std::move(data));
 }
 
 void ADriverOdbc::exec(const std::shared_ptr<ADriver> &db,
@@ -1060,13 +1276,7 @@ void ADriverOdbc::exec(const std::shared_ptr<ADriver> &db,
     data.result->m_query     = query.toUtf8();
     data.result->m_queryArgs = params;
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &AOdbcThread::query, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(
-        &m_worker, "query", Qt::QueuedConnection, Q_ARG(ASql::OdbcQueryPromise, std::move(data)));
-#endif
+    dispatch(&AOdbcThread::query, std::move(data));
 }
 
 void ADriverOdbc::exec(const std::shared_ptr<ADriver> &db,
@@ -1089,15 +1299,51 @@ void ADriverOdbc::exec(const std::shared_ptr<ADriver> &db,
     data.result->m_query     = query.query();
     data.result->m_queryArgs = params;
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &AOdbcThread::queryPrepared, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(&m_worker,
-                              "queryPrepared",
-                              Qt::QueuedConnection,
-                              Q_ARG(ASql::OdbcQueryPromise, std::move(data)));
-#endif
+    dispatch(&AOdbcThread::queryPrepared, std::move(data));
+}
+
+void ADriverOdbc::execBatch(const std::shared_ptr<ADriver> &db,
+                            QStringView query,
+                            const QList<QVariantList> &rows,
+                            QObject *receiver,
+                            ACoroDataRef cb)
+{
+    ++m_queueSize;
+    selfDriver = db;
+
+    OdbcQueryPromise data{
+        .batch  = rows,
+        .cb     = std::move(cb),
+        .result = std::make_shared<AResultOdbc>(),
+    };
+    if (receiver) {
+        data.receiver = receiver;
+    }
+    data.result->m_query = query.toUtf8();
+
+    dispatch(&AOdbcThread::queryBatch, std::move(data));
+}
+
+void ADriverOdbc::execBatch(const std::shared_ptr<ADriver> &db,
+                            QUtf8StringView query,
+                            const QList<QVariantList> &rows,
+                            QObject *receiver,
+                            ACoroDataRef cb)
+{
+    ++m_queueSize;
+    selfDriver = db;
+
+    OdbcQueryPromise data{
+        .batch  = rows,
+        .cb     = std::move(cb),
+        .result = std::make_shared<AResultOdbc>(),
+    };
+    if (receiver) {
+        data.receiver = receiver;
+    }
+    data.result->m_query.setRawData(query.data(), query.size());
+
+    dispatch(&AOdbcThread::queryBatch, std::move(data));
 }
 
 void ADriverOdbc::setLastQuerySingleRowMode()
@@ -1174,7 +1420,7 @@ QVariantList AResultOdbc::queryArgs() const
 
 int AResultOdbc::size() const
 {
-    return m_fields.empty() ? 0 : m_rows.size() / m_fields.size();
+    return m_data.rows();
 }
 
 int AResultOdbc::fields() const
@@ -1187,11 +1433,6 @@ qint64 AResultOdbc::numRowsAffected() const
     return m_numRowsAffected;
 }
 
-int AResultOdbc::indexOfField(QLatin1String name) const
-{
-    return m_fields.indexOf(name);
-}
-
 QString AResultOdbc::fieldName(int column) const
 {
     return m_fields.at(column);
@@ -1199,57 +1440,57 @@ QString AResultOdbc::fieldName(int column) const
 
 QVariant AResultOdbc::value(int row, int column) const
 {
-    return m_rows.at(row * m_fields.size() + column);
+    return m_data.value(row, column);
 }
 
 bool AResultOdbc::isNull(int row, int column) const
 {
-    return value(row, column).isNull();
+    return m_data.isNull(row, column);
 }
 
 bool AResultOdbc::toBool(int row, int column) const
 {
-    return value(row, column).toBool();
+    return m_data.toBool(row, column);
 }
 
 int AResultOdbc::toInt(int row, int column) const
 {
-    return value(row, column).toInt();
+    return int(m_data.toLongLong(row, column));
 }
 
 qint64 AResultOdbc::toLongLong(int row, int column) const
 {
-    return value(row, column).toLongLong();
+    return m_data.toLongLong(row, column);
 }
 
 quint64 AResultOdbc::toULongLong(int row, int column) const
 {
-    return value(row, column).toULongLong();
+    return m_data.toULongLong(row, column);
 }
 
 double AResultOdbc::toDouble(int row, int column) const
 {
-    return value(row, column).toDouble();
+    return m_data.toDouble(row, column);
 }
 
 QString AResultOdbc::toString(int row, int column) const
 {
-    return value(row, column).toString();
+    return m_data.toString(row, column);
 }
 
 std::string AResultOdbc::toStdString(int row, int column) const
 {
-    return toString(row, column).toStdString();
+    return m_data.toStdString(row, column);
 }
 
 QUuid AResultOdbc::toUuid(int row, int column) const
 {
-    return QUuid::fromString(value(row, column).toString());
+    return m_data.toUuid(row, column);
 }
 
 QDate AResultOdbc::toDate(int row, int column) const
 {
-    return value(row, column).toDate();
+    return m_data.toDate(row, column);
 }
 
 QTime AResultOdbc::toTime(int row, int column) const
@@ -1275,7 +1516,35 @@ QCborValue AResultOdbc::toCborValue(int row, int column) const
 
 QByteArray AResultOdbc::toByteArray(int row, int column) const
 {
-    return value(row, column).toByteArray();
+    return m_data.toByteArray(row, column);
+}
+
+void AResultOdbc::columnInto(int column, std::span<int> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
+}
+
+void AResultOdbc::columnInto(int column, std::span<qint64> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
+}
+
+void AResultOdbc::columnInto(int column, std::span<double> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
+}
+
+void AResultOdbc::columnInto(int column, std::span<QString> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
 }
 
 } // namespace ASql
@@ -4,18 +4,20 @@
  */
 #pragma once
 
+#include "acolumnardata.h"
 #include "adriver.h"
 #include "apreparedquery.h"
 #include "aresult.h"
+#include "aspscqueue.h"
+#include "astrand.h"
 
+#include <atomic>
 #include <optional>
 #include <sql.h>
 #include <sqlext.h>
 
 #include <QHash>
-#include <QMutex>
 #include <QPointer>
-#include <QQueue>
 #include <QThread>
 
 namespace ASql {
@@ -37,7 +39,6 @@ public:
     int fields() const override;
     qint64 numRowsAffected() const override;
 
-    int indexOfField(QLatin1String name) const override;
     QString fieldName(int column) const override;
     inline QVariant value(int row, int column) const override;
 
@@ -57,9 +58,14 @@ public:
     QCborValue toCborValue(int row, int column) const final;
     QByteArray toByteArray(int row, int column) const override;
 
+    void columnInto(int column, std::span<int> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<qint64> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<double> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<QString> out, std::span<quint64> nulls) const override;
+
     QByteArray m_query;
     QVariantList m_queryArgs;
-    QVariantList m_rows;
+    AColumnarData m_data;
     std::optional<QString> m_error;
     QStringList m_fields;
     qint64 m_numRowsAffected = -1;
@@ -73,6 +79,7 @@ struct OdbcOpenPromise {
 
 struct OdbcQueryPromise {
     std::optional<APreparedQuery> preparedQuery;
+    QList<QVariantList> batch;
     ACoroDataRef cb;
     std::shared_ptr<AResultOdbc> result;
     std::optional<QPointer<QObject>> receiver;
@@ -85,14 +92,15 @@ public:
     AOdbcThread(const QString &connInfo);
     ~AOdbcThread();
 
-    QMutex m_promisesMutex;
-    QQueue<ASql::OdbcQueryPromise> m_promisesReady;
+    ASpscQueue<ASql::OdbcQueryPromise> m_promisesReady;
+    std::atomic<bool> m_closing = false;
 
 public Q_SLOTS:
     void open();
     void query(ASql::OdbcQueryPromise promise);
     void queryPrepared(ASql::OdbcQueryPromise promise);
     void queryExec(ASql::OdbcQueryPromise promise);
+    void queryBatch(ASql::OdbcQueryPromise promise);
 
 Q_SIGNALS:
     void openned(bool isOpen, QString error);
@@ -100,8 +108,11 @@ Q_SIGNALS:
 
 private:
     QString odbcError(SQLSMALLINT handleType, SQLHANDLE handle);
+    void enqueueAndSignal(OdbcQueryPromise &promise);
+    bool interrupted() const;
+    std::optional<QString> execDirect(QStringView query);
     void fetchResults(SQLHSTMT stmt, OdbcQueryPromise &promise);
-    QVariant columnValue(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT sqlType);
+    void appendColumn(SQLHSTMT stmt, SQLUSMALLINT col, SQLSMALLINT sqlType, AColumnarData &data);
     QString readWCharColumn(SQLHSTMT stmt, SQLUSMALLINT col);
     void bindParameters(SQLHSTMT stmt,
                         const QVariantList &params,
@@ -113,13 +124,15 @@ private:
     QString m_connString;
     SQLHENV m_env = SQL_NULL_HENV;
     SQLHDBC m_dbc = SQL_NULL_HDBC;
+    // A transaction begun with SQL, as \sa ADriverOdbc::begin() does
+    bool m_inTransaction = false;
 };
 
 class ADriverOdbc final : public ADriver
 {
     Q_OBJECT
 public:
-    ADriverOdbc(const QString &connInfo);
+    ADriverOdbc(const QString &connInfo, QThreadPool *pool = nullptr);
     virtual ~ADriverOdbc();
 
     QString driverName() const override;
@@ -164,6 +177,17 @@ public:
               QObject *receiver,
               ACoroDataRef cb) override;
 
+    void execBatch(const std::shared_ptr<ADriver> &db,
+                   QStringView query,
+                   const QList<QVariantList> &rows,
+                   QObject *receiver,
+                   ACoroDataRef cb) override;
+    void execBatch(const std::shared_ptr<ADriver> &db,
+                   QUtf8StringView query,
+                   const QList<QVariantList> &rows,
+                   QObject *receiver,
+                   ACoroDataRef cb) override;
+
     void setLastQuerySingleRowMode() override;
 
     bool enterPipelineMode(std::chrono::milliseconds timeout) override;
@@ -185,11 +209,16 @@ public:
                                      const QString &name) override;
 
 private:
+    // Runs a worker method on the connection thread or on the strand
+    template <typename Method, typename... Args>
+    void dispatch(Method method, Args... args);
+
     std::optional<QPointer<QObject>> m_stateChangedReceiver;
     std::function<void(ADatabase::State, const QString &)> m_stateChangedCb;
     std::shared_ptr<ADriver> selfDriver;
     AOdbcThread m_worker;
     QThread m_thread;
+    std::unique_ptr<AStrand> m_strand;
     ADatabase::State m_state = ADatabase::State::Disconnected;
     int m_queueSize          = 0;
 };
@@ -6,27 +6,41 @@
 #include <QJsonObject>
 #include <QLoggingCategory>
 #include <QMetaMethod>
-#include <QMutexLocker>
+#include <QRandomGenerator>
 #include <QUrl>
 #include <QUrlQuery>
 
+#include <algorithm>
+#ifdef HAVE_SQLITE3_UNLOCK_NOTIFY
+#    include <condition_variable>
+#    include <mutex>
+#endif
+#include <string_view>
+#include <thread>
+#include <utility>
+
 Q_LOGGING_CATEGORY(ASQL_SQLITE, "asql.sqlite", QtInfoMsg)
 
 using namespace Qt::StringLiterals;
 
 namespace ASql {
 
-ADriverSqlite::ADriverSqlite(const QString &connInfo)
+ADriverSqlite::ADriverSqlite(const QString &connInfo, QThreadPool *pool)
     : ADriver{connInfo}
     , m_worker{connInfo}
 {
-    m_thread.setObjectName(connInfo);
-    m_worker.moveToThread(&m_thread);
+    if (pool) {
+        m_strand = std::make_unique<AStrand>(pool);
+    } else {
+        m_thread.setObjectName(connInfo);
+        m_worker.moveToThread(&m_thread);
+    }
 
     connect(&m_worker, &ASqliteThread::queryReady, this, [this] {
-        QMutexLocker _(&m_worker.m_promisesMutex);
-        while (!m_worker.m_promisesReady.isEmpty()) {
-            QueryPromise promise = m_worker.m_promisesReady.dequeue();
+        m_worker.m_promisesReady.wakeupReceived();
+        while (auto ready = m_worker.m_promisesReady.pop()) {
+            QueryPromise promise = std::move(*ready);
+            m_autocommit         = promise.result->m_autocommit;
             if (!promise.receiver.has_value() || !promise.receiver->isNull()) {
                 if (promise.cb) {
                     AResult result{promise.result};
@@ -34,6 +48,14 @@ ADriverSqlite::ADriverSqlite(const QString &connInfo)
                 }
             }
 
+            if (promise.streamed) {
+                m_worker.m_batchSlots.release();
+            }
+
+            if (promise.result->m_lastResultSet) {
+                disconnect(promise.receiverDestroyed);
+            }
+
             if (promise.result->m_lastResultSet && --m_queueSize == 0) {
                 // This might not be needed if we only use coroutines
                 // since db object won't go out of scope when we are waiting for a reply
@@ -44,18 +66,54 @@ ADriverSqlite::ADriverSqlite(const QString &connInfo)
         }
     }, Qt::QueuedConnection);
 
-    m_thread.start();
+    if (!m_strand) {
+        m_thread.start();
+    }
 }
 
 ADriverSqlite::~ADriverSqlite()
 {
     Q_ASSERT(m_thread.thread() == QThread::currentThread());
 
+    // Queued tasks are dropped as with the thread, but the running one must finish
+    m_worker.m_closing = true;
+    m_worker.interrupt(0);
+    m_strand.reset();
+
     m_thread.requestInterruption();
     m_thread.quit();
     m_thread.wait();
 }
 
+template <typename Method, typename... Args>
+void ADriverSqlite::dispatch(Method method, Args... args)
+{
+    auto task = [worker = &m_worker, method, ... args = std::move(args)]() mutable {
+        (worker->*method)(std::move(args)...);
+    };
+
+    if (m_strand) {
+        m_strand->post(std::move(task));
+    } else {
+        QMetaObject::invokeMethod(&m_worker, std::move(task), Qt::QueuedConnection);
+    }
+}
+
+/**
+ * Interrupts the query of \a promise if \a receiver is destroyed while it runs,
+ * queued queries check the receiver when they start.
+ */
+void ADriverSqlite::setupCheckReceiver(QueryPromise &promise, QObject *receiver)
+{
+    if (receiver) {
+        promise.receiver          = receiver;
+        promise.receiverDestroyed =
+            connect(receiver, &QObject::destroyed, this, [this, id = promise.id] {
+                m_worker.interrupt(id);
+            });
+    }
+}
+
 QString ADriverSqlite::driverName() const
 {
     return u"sqlite"_s;
@@ -109,11 +167,7 @@ void ADriverSqlite::open(const std::shared_ptr<ADriver> &driver, QObject *receiv
         }
     }, Qt::SingleShotConnection);
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(&m_worker, &ASqliteThread::open, Qt::QueuedConnection);
-#else
-    QMetaObject::invokeMethod(&m_worker, "open", Qt::QueuedConnection);
-#endif
+    dispatch(&ASqliteThread::open);
 }
 
 bool ADriverSqlite::isOpen() const
@@ -121,6 +175,11 @@ bool ADriverSqlite::isOpen() const
     return m_state == ADatabase::State::Connected;
 }
 
+bool ADriverSqlite::autocommit() const
+{
+    return m_autocommit;
+}
+
 void ADriverSqlite::setState(ADatabase::State state, const QString &status)
 {
     m_state = state;
@@ -171,18 +230,11 @@ void ADriverSqlite::exec(const std::shared_ptr<ADriver> &db,
         .cb     = std::move(cb),
         .result = std::make_shared<AResultSqlite>(),
     };
-    if (receiver) {
-        data.receiver = receiver;
-    }
+    data.id = ++m_lastQueryId;
+    setupCheckReceiver(data, receiver);
     data.result->m_query.setRawData(query.data(), query.size());
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &ASqliteThread::queryExec, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(
-        &m_worker, "queryExec", Qt::QueuedConnection, Q_ARG(ASql::QueryPromise, std::move(data)));
-#endif
+    dispatch(&ASqliteThread::queryExec, std::move(data));
 }
 
 void ADriverSqlite::exec(const std::shared_ptr<ADriver> &db,
@@ -197,18 +249,11 @@ void ADriverSqlite::exec(const std::shared_ptr<ADriver> &db,
         .cb     = std::move(cb),
         .result = std::make_shared<AResultSqlite>(),
     };
-    if (receiver) {
-        data.receiver = receiver;
-    }
+    data.id = ++m_lastQueryId;
+    setupCheckReceiver(data, receiver);
     data.result->m_query = query.toUtf8();
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &ASqliteThread::queryExec, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(
-        &m_worker, "queryExec", Qt::QueuedConnection, Q_ARG(ASql::QueryPromise, std::move(data)));
-#endif
+    dispatch(&ASqliteThread::queryExec, std::move(data));
 }
 
 void ADriverSqlite::exec(const std::shared_ptr<ADriver> &db,
@@ -224,19 +269,12 @@ void ADriverSqlite::exec(const std::shared_ptr<ADriver> &db,
         .cb     = std::move(cb),
         .result = std::make_shared<AResultSqlite>(),
     };
-    if (receiver) {
-        data.receiver = receiver;
-    }
+    data.id = ++m_lastQueryId;
+    setupCheckReceiver(data, receiver);
     data.result->m_query.setRawData(query.data(), query.size());
     data.result->m_queryArgs = params;
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &ASqliteThread::query, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(
-        &m_worker, "query", Qt::QueuedConnection, Q_ARG(ASql::QueryPromise, std::move(data)));
-#endif
+    dispatch(&ASqliteThread::query, std::move(data));
 }
 
 void ADriverSqlite::exec(const std::shared_ptr<ADriver> &db,
@@ -252,19 +290,12 @@ void ADriverSqlite::exec(const std::shared_ptr<ADriver> &db,
         .cb     = std::move(cb),
         .result = std::make_shared<AResultSqlite>(),
     };
-    if (receiver) {
-        data.receiver = receiver;
-    }
+    data.id = ++m_lastQueryId;
+    setupCheckReceiver(data, receiver);
     data.result->m_query     = query.toUtf8();
     data.result->m_queryArgs = params;
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &ASqliteThread::query, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(
-        &m_worker, "query", Qt::QueuedConnection, Q_ARG(ASql::QueryPromise, std::move(data)));
-#endif
+    dispatch(&ASqliteThread::query, std::move(data));
 }
 
 void ADriverSqlite::exec(const std::shared_ptr<ADriver> &db,
@@ -281,25 +312,60 @@ void ADriverSqlite::exec(const std::shared_ptr<ADriver> &db,
         .cb            = std::move(cb),
         .result        = std::make_shared<AResultSqlite>(),
     };
-    if (receiver) {
-        data.receiver = receiver;
-    }
+    data.id = ++m_lastQueryId;
+    setupCheckReceiver(data, receiver);
     data.result->m_query     = query.query();
     data.result->m_queryArgs = params;
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &ASqliteThread::queryPrepared, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(&m_worker,
-                              "queryPrepared",
-                              Qt::QueuedConnection,
-                              Q_ARG(ASql::QueryPromise, std::move(data)));
-#endif
+    dispatch(&ASqliteThread::queryPrepared, std::move(data));
+}
+
+void ADriverSqlite::execBatch(const std::shared_ptr<ADriver> &db,
+                              QStringView query,
+                              const QList<QVariantList> &rows,
+                              QObject *receiver,
+                              ACoroDataRef cb)
+{
+    ++m_queueSize;
+    selfDriver = db;
+
+    QueryPromise data{
+        .batch  = rows,
+        .cb     = std::move(cb),
+        .result = std::make_shared<AResultSqlite>(),
+    };
+    data.id = ++m_lastQueryId;
+    setupCheckReceiver(data, receiver);
+    data.result->m_query = query.toUtf8();
+
+    dispatch(&ASqliteThread::queryBatch, std::move(data));
+}
+
+void ADriverSqlite::execBatch(const std::shared_ptr<ADriver> &db,
+                              QUtf8StringView query,
+                              const QList<QVariantList> &rows,
+                              QObject *receiver,
+                              ACoroDataRef cb)
+{
+    ++m_queueSize;
+    selfDriver = db;
+
+    QueryPromise data{
+        .batch  = rows,
+        .cb     = std::move(cb),
+        .result = std::make_shared<AResultSqlite>(),
+    };
+    data.id = ++m_lastQueryId;
+    setupCheckReceiver(data, receiver);
+    data.result->m_query.setRawData(query.data(), query.size());
+
+    dispatch(&ASqliteThread::queryBatch, std::move(data));
 }
 
 void ADriverSqlite::setLastQuerySingleRowMode()
 {
+    // Checked by the worker each time it has a batch of rows ready
+    m_worker.m_singleRowQuery = m_lastQueryId;
 }
 
 bool ADriverSqlite::enterPipelineMode(std::chrono::milliseconds timeout)
@@ -351,17 +417,196 @@ ASqliteThread::ASqliteThread(const QString &connInfo)
 
 ASqliteThread::~ASqliteThread()
 {
+    // Statements must be finalized before the connection is closed
+    m_statementCacheIndex.clear();
+    m_statementCache.clear();
+    m_preparedQueries.clear();
     sqlite3_close_v2(m_db);
 }
 
+/**
+ * Called by SQLite while another connection holds the lock a statement needs.
+ * The sleep doubles on each retry from BUSY_SLEEP up to BUSY_MAX_SLEEP with a
+ * random jitter, so that waiting writers don't retry in lockstep, until the
+ * BUSY_TIMEOUT budget of the query or the BUSY_RETRIES limit of this statement
+ * step are exhausted.
+ */
 int ASqliteThread::busyHandler(void *data, int retry_count)
 {
-    auto worker = static_cast<ASqliteThread *>(data);
-    if (retry_count >= worker->m_busyRetries) {
-        return 0; // Stop retrying
+    using namespace std::chrono;
+
+    auto worker          = static_cast<ASqliteThread *>(data);
+    const auto remaining = worker->lockDeadline() - steady_clock::now();
+    if (remaining <= 0ms || worker->interrupted() ||
+        (worker->m_busyRetries > 0 && retry_count >= worker->m_busyRetries)) {
+        return 0; // Fail with SQLITE_BUSY
+    }
+
+    // Sleeps a random time in the upper half of the current backoff
+    const milliseconds backoff = worker->m_busyRetrySleep * (1 << std::min(retry_count, 20));
+
+    const auto ceiling = duration_cast<microseconds>(std::min(backoff, worker->m_busyMaxSleep));
+    const auto jitter  = ceiling / 2 * QRandomGenerator::global()->generateDouble();
+    const auto sleep   = ceiling / 2 + duration_cast<microseconds>(jitter);
+    std::this_thread::sleep_for(std::min<steady_clock::duration>(sleep, remaining));
+    return 1;
+}
+
+/**
+ * Called by SQLite every thousand virtual machine instructions, a non zero
+ * return aborts the statement with SQLITE_INTERRUPT, which also covers the time
+ * between the checks done for each row, like in aggregates or sorts.
+ */
+int ASqliteThread::progressHandler(void *data)
+{
+    return static_cast<ASqliteThread *>(data)->interrupted() ? 1 : 0;
+}
+
+#ifdef HAVE_SQLITE3_UNLOCK_NOTIFY
+struct UnlockNotification {
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool fired       = false;
+    bool interrupted = false;
+};
+
+namespace {
+
+void unlockNotify(void **args, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        auto notification = static_cast<UnlockNotification *>(args[i]);
+        std::lock_guard lock{notification->mutex};
+        notification->fired = true;
+        notification->cond.notify_one();
+    }
+}
+
+} // namespace
+#endif
+
+void ASqliteThread::interrupt(quint64 id)
+{
+    std::lock_guard lock{m_runningMutex};
+    if (m_runningQuery && (id == 0 || m_runningQuery == id)) {
+        sqlite3_interrupt(m_db);
+#ifdef HAVE_SQLITE3_UNLOCK_NOTIFY
+        if (m_unlockNotification) {
+            std::lock_guard notificationLock{m_unlockNotification->mutex};
+            m_unlockNotification->interrupted = true;
+            m_unlockNotification->cond.notify_one();
+        }
+#endif
+    }
+}
+
+/**
+ * The waits of a query for locks held by other connections share one
+ * BUSY_TIMEOUT budget, started by the first of them and bounded by QUERY_TIMEOUT.
+ */
+std::chrono::steady_clock::time_point ASqliteThread::lockDeadline()
+{
+    if (!m_lockDeadline) {
+        m_lockDeadline = std::chrono::steady_clock::now() + m_busyTimeout;
+    }
+    if (m_queryTimeout > 0ms && m_runningQuery) {
+        return std::min(*m_lockDeadline, m_deadline);
+    }
+    return *m_lockDeadline;
+}
+
+/**
+ * Marks \a promise as the running query, returning false without running it
+ * when its receiver was destroyed while it was queued.
+ */
+bool ASqliteThread::start(QueryPromise &promise)
+{
+    if (promise.receiver.has_value() && promise.receiver->isNull()) {
+        promise.result->m_error = u"Interrupt requested"_s;
+        return false;
+    }
+
+    std::lock_guard lock{m_runningMutex};
+    m_runningQuery    = promise.id;
+    m_runningReceiver = promise.receiver;
+    m_deadline        = std::chrono::steady_clock::now() + m_queryTimeout;
+    m_lockDeadline.reset();
+    return true;
+}
+
+void ASqliteThread::finish()
+{
+    std::lock_guard lock{m_runningMutex};
+    m_runningQuery = 0;
+    m_runningReceiver.reset();
+    m_lockDeadline.reset();
+}
+
+/**
+ * Tables of a shared cache are locked by the connection writing to them, when
+ * \a res is such an error this blocks until that transaction ends, instead of
+ * polling, if SQLite is built with SQLITE_ENABLE_UNLOCK_NOTIFY.
+ *
+ * Returns true if the statement can be retried, false if it should fail because
+ * of another error, waiting would deadlock, the query was interrupted or its
+ * BUSY_TIMEOUT budget passed.
+ */
+bool ASqliteThread::waitForUnlock(int res)
+{
+    if (res != SQLITE_LOCKED || sqlite3_extended_errcode(m_db) != SQLITE_LOCKED_SHAREDCACHE) {
+        return false;
+    }
+
+#ifdef HAVE_SQLITE3_UNLOCK_NOTIFY
+    UnlockNotification notification;
+    if (sqlite3_unlock_notify(m_db, unlockNotify, &notification) != SQLITE_OK) {
+        return false;
+    }
+
+    {
+        std::lock_guard lock{m_runningMutex};
+        m_unlockNotification = &notification;
+    }
+    auto _ = qScopeGuard([this] {
+        std::lock_guard lock{m_runningMutex};
+        m_unlockNotification = nullptr;
+    });
+
+    std::unique_lock lock{notification.mutex};
+    notification.cond.wait_until(lock, lockDeadline(), [&] {
+        return notification.fired || notification.interrupted;
+    });
+    if (!notification.fired) {
+        lock.unlock();
+        // Cancels the callback, SQLite serializes it with a running one
+        sqlite3_unlock_notify(m_db, nullptr, nullptr);
+        return false;
+    }
+    return !notification.interrupted && !interrupted();
+#else
+    return false;
+#endif
+}
+
+int ASqliteThread::step(sqlite3_stmt *stmt)
+{
+    int res = sqlite3_step(stmt);
+    while (waitForUnlock(res)) {
+        sqlite3_reset(stmt);
+        res = sqlite3_step(stmt);
+    }
+    return res;
+}
+
+void ASqliteThread::enqueueAndSignal(QueryPromise &promise)
+{
+    // Read here as later statements might already be running when it's delivered
+    promise.result->m_autocommit = sqlite3_get_autocommit(m_db) != 0;
+
+    // Only the first result since the owner thread last drained the queue wakes it up
+    if (m_promisesReady.push(std::move(promise))) {
+        Q_EMIT queryReady();
     }
-    usleep(worker->m_busyRetrySleep.count()); // Wait 100ms
-    return 1;                                 // Continue retrying
 }
 
 void ASqliteThread::open()
@@ -392,19 +637,43 @@ void ASqliteThread::open()
         }
     }();
 
-    const int res = sqlite3_open_v2(filename.toUtf8().constData(), &m_db, openMode, NULL);
+    int res = sqlite3_open_v2(filename.toUtf8().constData(), &m_db, openMode, NULL);
+    if (res == SQLITE_OK && query.hasQueryItem(u"WAL"_s)) {
+        res = sqlite3_exec(m_db, "PRAGMA journal_mode=WAL", nullptr, nullptr, nullptr);
+    }
+
     if (res == SQLITE_OK) {
         Q_EMIT openned(true, {});
 
+        if (query.hasQueryItem(u"BUSY_TIMEOUT"_s)) {
+            m_busyTimeout =
+                std::chrono::milliseconds{query.queryItemValue(u"BUSY_TIMEOUT"_s).toInt()};
+        }
         if (query.hasQueryItem(u"BUSY_RETRIES"_s)) {
-            m_busyRetries = query.queryItemValue(u"BUSY_RETRIES"_s).toInt();
+            m_busyRetries = std::max(0, query.queryItemValue(u"BUSY_RETRIES"_s).toInt());
         }
         if (query.hasQueryItem(u"BUSY_SLEEP"_s)) {
-            m_busyRetrySleep =
-                std::chrono::milliseconds{query.queryItemValue(u"BUSY_SLEEP"_s).toInt()};
+            m_busyRetrySleep = std::chrono::milliseconds{
+                std::max(1, query.queryItemValue(u"BUSY_SLEEP"_s).toInt())};
+        }
+        if (query.hasQueryItem(u"BUSY_MAX_SLEEP"_s)) {
+            m_busyMaxSleep = std::chrono::milliseconds{
+                std::max(1, query.queryItemValue(u"BUSY_MAX_SLEEP"_s).toInt())};
+        }
+        if (query.hasQueryItem(u"STATEMENT_CACHE"_s)) {
+            m_statementCacheSize =
+                std::max(0, query.queryItemValue(u"STATEMENT_CACHE"_s).toInt());
+        }
+        if (query.hasQueryItem(u"BATCH_ROWS"_s)) {
+            m_batchRows = std::max(1, query.queryItemValue(u"BATCH_ROWS"_s).toInt());
+        }
+        if (query.hasQueryItem(u"QUERY_TIMEOUT"_s)) {
+            m_queryTimeout = std::chrono::milliseconds{
+                std::max(0, query.queryItemValue(u"QUERY_TIMEOUT"_s).toInt())};
         }
 
         sqlite3_busy_handler(m_db, busyHandler, this);
+        sqlite3_progress_handler(m_db, 1000, progressHandler, this);
     } else {
         const char *sqliteError = sqlite3_errmsg(m_db);
         const QString error     = u"Failed to open database: %1"_s.arg(
@@ -426,34 +695,34 @@ QStringList fillColumns(sqlite3_stmt *stmt)
     return columns;
 }
 
-void fillRow(sqlite3_stmt *stmt, int columnsCount, QVariantList &rows)
+void fillRow(sqlite3_stmt *stmt, int columnsCount, AColumnarData &rows)
 {
-    const int currentRow = rows.size();
-    rows.resize(rows.size() + columnsCount);
-
     for (int i = 0; i < columnsCount; i++) {
         switch (sqlite3_column_type(stmt, i)) {
         case SQLITE_BLOB:
-            rows[currentRow + i] =
-                QByteArray(static_cast<const char *>(sqlite3_column_blob(stmt, i)),
-                           sqlite3_column_bytes(stmt, i));
+        {
+            // The size must be read after the conversion
+            const auto blob = static_cast<const char *>(sqlite3_column_blob(stmt, i));
+            rows.appendBytes(QByteArrayView(blob, sqlite3_column_bytes(stmt, i)));
             break;
+        }
         case SQLITE_INTEGER:
-            rows[currentRow + i] = sqlite3_column_int64(stmt, i);
+            rows.appendInt(sqlite3_column_int64(stmt, i));
             break;
         case SQLITE_FLOAT:
-            rows[currentRow + i] = sqlite3_column_double(stmt, i);
-            break;
+            rows.appendDouble(sqlite3_column_double(stmt, i));
             break;
         case SQLITE_NULL:
-            rows[currentRow + i] = QVariant(QMetaType::fromType<QString>());
+            rows.appendNull(QMetaType::fromType<QString>());
             break;
         default:
-            rows[currentRow + i] =
-                QString(reinterpret_cast<const QChar *>(sqlite3_column_text16(stmt, i)),
-                        sqlite3_column_bytes16(stmt, i) / sizeof(QChar));
+        {
+            // UTF-8 is the native encoding of the database, kept as is in the text arena
+            const auto text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, i));
+            rows.appendText(QByteArrayView(text, sqlite3_column_bytes(stmt, i)));
             break;
         }
+        }
     }
 }
 
@@ -529,52 +798,132 @@ std::optional<QString> bindValues(sqlite3 *db, sqlite3_stmt *stmt, const QVarian
     return {};
 }
 
-void ASqliteThread::query(QueryPromise promise)
+/**
+ * Steps \a stmt into the promise result. When the query was set to single row mode
+ * every m_batchRows rows are handed to the owner thread as a result of their own,
+ * the last batch, possibly empty, is left in the promise with the final status.
+ */
+bool ASqliteThread::stepRows(QueryPromise &promise, sqlite3_stmt *stmt)
 {
-    auto _ = qScopeGuard([&] {
-        {
-            QMutexLocker _(&m_promisesMutex);
-            m_promisesReady.enqueue(std::move(promise));
-        }
-        Q_EMIT queryReady();
-    });
-
-    auto stmt = prepare(promise, 0x0);
-    if (!stmt) {
-        return;
-    }
-
-    auto bindError = bindValues(m_db, stmt.get(), promise.result->m_queryArgs);
-    if (bindError.has_value()) {
-        promise.result->m_error = bindError;
-        return;
-    }
-
-    promise.result->m_fields = fillColumns(stmt.get());
+    const int columns = promise.result->m_fields.size();
 
-    QVariantList rows;
+    AColumnarData rows;
+    rows.reset(columns);
     do {
-        if (QThread::currentThread()->isInterruptionRequested()) {
+        if (interrupted()) {
             promise.result->m_error = u"Interrupt requested"_s;
-            return;
+            return false;
         }
 
-        int res = sqlite3_step(stmt.get());
+        int res = step(stmt);
         if (res != SQLITE_ROW) {
+            if (res == SQLITE_INTERRUPT && timedOut()) {
+                promise.result->m_error =
+                    u"Query timed out after %1ms"_s.arg(QString::number(m_queryTimeout.count()));
+                return false;
+            }
+
             if (res != SQLITE_DONE) {
                 const char *sqliteError = sqlite3_errmsg(m_db);
                 promise.result->m_error = u"Failed to execute query: '%2'"_s.arg(
                     sqliteError ? QString::fromUtf8(sqliteError) : u"Unknown error"_s);
-                return;
+                return false;
             }
             break;
         }
 
-        fillRow(stmt.get(), promise.result->m_fields.size(), rows);
+        fillRow(stmt, columns, rows);
+
+        if (columns && rows.rows() >= m_batchRows &&
+            m_singleRowQuery.load(std::memory_order_relaxed) == promise.id) {
+            if (!enqueueBatch(promise, rows)) {
+                return false;
+            }
+        }
     } while (true);
 
     promise.result->m_numRowsAffected = sqlite3_changes64(m_db);
-    promise.result->m_rows            = rows;
+    promise.result->m_data            = std::move(rows);
+    return true;
+}
+
+bool ASqliteThread::enqueueBatch(QueryPromise &promise, AColumnarData &rows)
+{
+    // Keep the memory bounded when the owner thread can't keep up with the statement
+    while (!m_batchSlots.tryAcquire(1, 100)) {
+        if (interrupted()) {
+            promise.result->m_error = u"Interrupt requested"_s;
+            return false;
+        }
+    }
+
+    auto next         = std::make_shared<AResultSqlite>();
+    next->m_query     = promise.result->m_query;
+    next->m_queryArgs = promise.result->m_queryArgs;
+    next->m_fields    = promise.result->m_fields;
+
+    promise.result->m_data          = std::move(rows);
+    promise.result->m_lastResultSet = false;
+    rows.reset(next->m_fields.size());
+
+    QueryPromise batch = promise;
+    batch.streamed     = true;
+    enqueueAndSignal(batch);
+
+    promise.result = std::move(next);
+    return true;
+}
+
+/**
+ * True when the driver is closing or the running query should stop because its
+ * receiver was destroyed, QPointer reads the object's reference count atomically,
+ * or QUERY_TIMEOUT passed.
+ */
+bool ASqliteThread::interrupted() const
+{
+    return m_closing.load(std::memory_order_relaxed) ||
+           QThread::currentThread()->isInterruptionRequested() ||
+           (m_runningReceiver.has_value() && m_runningReceiver->isNull()) || timedOut();
+}
+
+bool ASqliteThread::timedOut() const
+{
+    return m_queryTimeout > 0ms && m_runningQuery &&
+           std::chrono::steady_clock::now() >= m_deadline;
+}
+
+void ASqliteThread::query(QueryPromise promise)
+{
+    std::shared_ptr<sqlite3_stmt> stmt;
+
+    const QByteArray query = promise.result->m_query;
+    auto _                 = qScopeGuard([&] {
+        finish();
+
+        // Reset before the result holding the bound values is handed over
+        releaseCached(query, stmt.get());
+
+        enqueueAndSignal(promise);
+    });
+
+    if (!start(promise)) {
+        return;
+    }
+
+    stmt = prepareCached(promise);
+    if (!stmt) {
+        return;
+    }
+
+    auto bindError = bindValues(m_db, stmt.get(), promise.result->m_queryArgs);
+    if (bindError.has_value()) {
+        promise.result->m_error = bindError;
+        return;
+    }
+
+    promise.result->m_fields = fillColumns(stmt.get());
+
+    stepRows(promise, stmt.get());
 }
 
 void ASqliteThread::queryPrepared(QueryPromise promise)
@@ -583,11 +932,11 @@ void ASqliteThread::queryPrepared(QueryPromise promise)
 
     const auto queryId = promise.preparedQuery->identification();
     auto _             = qScopeGuard([&] {
-        {
-            QMutexLocker _(&m_promisesMutex);
-            m_promisesReady.enqueue(std::move(promise));
+        finish();
+        enqueueAndSignal(promise);
+        if (!stmt) {
+            return;
         }
-        Q_EMIT queryReady();
 
         // Make the statement ready to be used later
         if (sqlite3_reset(stmt.get()) != SQLITE_OK) {
@@ -607,6 +956,10 @@ void ASqliteThread::queryPrepared(QueryPromise promise)
         }
     });
 
+    if (!start(promise)) {
+        return;
+    }
+
     auto it = m_preparedQueries.constFind(queryId);
     if (it != m_preparedQueries.constEnd()) {
         stmt = it.value();
@@ -627,29 +980,7 @@ void ASqliteThread::queryPrepared(QueryPromise promise)
 
     promise.result->m_fields = fillColumns(stmt.get());
 
-    QVariantList rows;
-    do {
-        if (QThread::currentThread()->isInterruptionRequested()) {
-            promise.result->m_error = u"Interrupt requested"_s;
-            return;
-        }
-
-        int res = sqlite3_step(stmt.get());
-        if (res != SQLITE_ROW) {
-            if (res != SQLITE_DONE) {
-                const char *sqliteError = sqlite3_errmsg(m_db);
-                promise.result->m_error = u"Failed to execute query: '%2'"_s.arg(
-                    sqliteError ? QString::fromUtf8(sqliteError) : u"Unknown error"_s);
-                return;
-            }
-            break;
-        }
-
-        fillRow(stmt.get(), promise.result->m_fields.size(), rows);
-    } while (true);
-
-    promise.result->m_numRowsAffected = sqlite3_changes64(m_db);
-    promise.result->m_rows            = rows;
+    stepRows(promise, stmt.get());
 }
 
 /**
@@ -661,14 +992,15 @@ void ASqliteThread::queryPrepared(QueryPromise promise)
 void ASqliteThread::queryExec(QueryPromise promise)
 {
     auto _ = qScopeGuard([&] {
-        {
-            QMutexLocker _(&m_promisesMutex);
-            m_promisesReady.enqueue(std::move(promise));
-        }
-        Q_EMIT queryReady();
+        finish();
+        enqueueAndSignal(promise);
     });
 
-    int res                = SQLITE_OK;
+    if (!start(promise)) {
+        return;
+    }
+
+    int res                = SQLITE_OK;
     const QByteArray query = promise.result->m_query;
 
     bool emitQuery   = false;
@@ -698,11 +1030,8 @@ void ASqliteThread::queryExec(QueryPromise promise)
 
         if (emitQuery) {
             promise.result->m_lastResultSet = false;
-            {
-                QMutexLocker _(&m_promisesMutex);
-                m_promisesReady.enqueue(promise);
-            }
-            Q_EMIT queryReady();
+            auto ready = promise;
+            enqueueAndSignal(ready);
 
             promise.result          = std::make_shared<AResultSqlite>();
             promise.result->m_query = query;
@@ -714,30 +1043,9 @@ void ASqliteThread::queryExec(QueryPromise promise)
         promise.result->m_query  = QByteArray{zSql, zLeftover - zSql};
         promise.result->m_fields = fillColumns(stmt.get());
 
-        QVariantList rows;
-        do {
-            if (QThread::currentThread()->isInterruptionRequested()) {
-                promise.result->m_error = u"Interrupt requested"_s;
-                return;
-            }
-
-            res = sqlite3_step(stmt.get());
-
-            if (res != SQLITE_ROW) {
-                if (res != SQLITE_DONE) {
-                    const char *sqliteError = sqlite3_errmsg(m_db);
-                    promise.result->m_error = u"Failed to execute query: '%2'"_s.arg(
-                        sqliteError ? QString::fromUtf8(sqliteError) : u"Unknown error"_s);
-                    return;
-                }
-                break;
-            }
-
-            fillRow(stmt.get(), promise.result->m_fields.size(), rows);
-        } while (true);
-
-        promise.result->m_numRowsAffected = sqlite3_changes64(m_db);
-        promise.result->m_rows            = rows;
+        if (!stepRows(promise, stmt.get())) {
+            return;
+        }
 
         zSql = zLeftover;
         while (std::isspace(zSql[0])) {
@@ -747,13 +1055,108 @@ void ASqliteThread::queryExec(QueryPromise promise)
     }
 }
 
+/**
+ * Runs the statement once for each row of parameters inside a savepoint,
+ * which begins a transaction when none is open, so that the batch is applied
+ * atomically with a single prepare and a single commit.
+ */
+void ASqliteThread::queryBatch(QueryPromise promise)
+{
+    std::shared_ptr<sqlite3_stmt> stmt;
+
+    const QByteArray query = promise.result->m_query;
+    auto _                 = qScopeGuard([&] {
+        finish();
+        releaseCached(query, stmt.get());
+
+        enqueueAndSignal(promise);
+    });
+
+    if (!start(promise)) {
+        return;
+    }
+
+    auto sqliteError = [this] {
+        const char *error = sqlite3_errmsg(m_db);
+        return error ? QString::fromUtf8(error) : u"Unknown error"_s;
+    };
+
+    stmt = prepareCached(promise);
+    if (!stmt) {
+        return;
+    }
+
+    if (sqlite3_exec(m_db, "SAVEPOINT asql_batch", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        promise.result->m_error = u"Failed to begin batch: '%1'"_s.arg(sqliteError());
+        return;
+    }
+
+    qint64 changes                  = 0;
+    const QList<QVariantList> &rows = promise.batch;
+    for (qsizetype i = 0; i < rows.size(); ++i) {
+        if (interrupted()) {
+            promise.result->m_error = u"Interrupt requested"_s;
+            break;
+        }
+
+        auto bindError = bindValues(m_db, stmt.get(), rows.at(i));
+        if (bindError.has_value()) {
+            promise.result->m_error =
+                u"Failed to bind row %1: %2"_s.arg(QString::number(i), *bindError);
+            break;
+        }
+
+        // Rows returned by the statement, like with RETURNING, are discarded
+        int res;
+        do {
+            res = step(stmt.get());
+        } while (res == SQLITE_ROW);
+
+        if (res != SQLITE_DONE) {
+            promise.result->m_error =
+                u"Failed to execute row %1: '%2'"_s.arg(QString::number(i), sqliteError());
+            break;
+        }
+        changes += sqlite3_changes64(m_db);
+
+        sqlite3_reset(stmt.get());
+        sqlite3_clear_bindings(stmt.get());
+    }
+
+    // A statement left in progress would make the rollback fail
+    sqlite3_reset(stmt.get());
+
+    // The savepoint must be released even when the batch was interrupted
+    finish();
+
+    if (!promise.result->m_error &&
+        sqlite3_exec(m_db, "RELEASE asql_batch", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        promise.result->m_error = u"Failed to commit batch: '%1'"_s.arg(sqliteError());
+    }
+
+    if (promise.result->m_error) {
+        sqlite3_exec(m_db, "ROLLBACK TO asql_batch; RELEASE asql_batch", nullptr, nullptr, nullptr);
+        return;
+    }
+
+    promise.result->m_numRowsAffected = changes;
+}
+
 std::shared_ptr<sqlite3_stmt> ASqliteThread::prepare(QueryPromise &promise, int flags)
 {
     const auto size = promise.result->m_query.size() + 1;
 
     sqlite3_stmt *stmt = nullptr;
-    int res =
-        sqlite3_prepare_v3(m_db, promise.result->m_query.constData(), size, flags, &stmt, nullptr);
+    auto prepareV3     = [&] {
+        return sqlite3_prepare_v3(
+            m_db, promise.result->m_query.constData(), size, flags, &stmt, nullptr);
+    };
+
+    int res = prepareV3();
+    // Reading the schema of a shared cache might need to wait for a writer
+    while (waitForUnlock(res)) {
+        res = prepareV3();
+    }
     if (res != SQLITE_OK) {
         const char *sqliteError = sqlite3_errmsg(m_db);
         promise.result->m_error = u"Failed to prepare statement: %1"_s.arg(
@@ -764,6 +1167,58 @@ std::shared_ptr<sqlite3_stmt> ASqliteThread::prepare(QueryPromise &promise, int
     return std::shared_ptr<sqlite3_stmt>(stmt, [](sqlite3_stmt *stmt) { sqlite3_finalize(stmt); });
 }
 
+/**
+ * Ad-hoc statements are kept in a LRU cache keyed by their SQL text,
+ * so that hot parameterized queries skip SQLite parsing and planning.
+ * The size is set with the STATEMENT_CACHE URI option, 0 disables it.
+ */
+std::shared_ptr<sqlite3_stmt> ASqliteThread::prepareCached(QueryPromise &promise)
+{
+    if (m_statementCacheSize == 0) {
+        return prepare(promise, 0x0);
+    }
+
+    auto it = m_statementCacheIndex.constFind(promise.result->m_query);
+    if (it != m_statementCacheIndex.constEnd()) {
+        m_statementCache.splice(m_statementCache.begin(), m_statementCache, it.value());
+        return it.value()->second;
+    }
+
+    auto stmt = prepare(promise, SQLITE_PREPARE_PERSISTENT);
+    if (!stmt) {
+        return {};
+    }
+
+    if (m_statementCache.size() >= size_t(m_statementCacheSize)) {
+        m_statementCacheIndex.remove(m_statementCache.back().first);
+        m_statementCache.pop_back();
+    }
+
+    // The query might point to raw data owned by the caller
+    const QByteArray key{promise.result->m_query.constData(), promise.result->m_query.size()};
+    m_statementCache.emplace_front(key, stmt);
+    m_statementCacheIndex.insert(key, m_statementCache.begin());
+
+    return stmt;
+}
+
+void ASqliteThread::releaseCached(const QByteArray &query, sqlite3_stmt *stmt)
+{
+    auto it = m_statementCacheIndex.find(query);
+    if (!stmt || it == m_statementCacheIndex.end() || it.value()->second.get() != stmt) {
+        return;
+    }
+
+    // sqlite3_reset() returns the error of the last step, like a constraint violation,
+    // which leaves the statement reusable, only schema and misuse errors evict it
+    const int res = sqlite3_reset(stmt) & 0xff;
+    sqlite3_clear_bindings(stmt);
+    if (res == SQLITE_SCHEMA || res == SQLITE_MISUSE) {
+        m_statementCache.erase(it.value());
+        m_statementCacheIndex.erase(it);
+    }
+}
+
 bool AResultSqlite::lastResultSet() const
 {
     return m_lastResultSet;
@@ -791,7 +1246,7 @@ QVariantList AResultSqlite::queryArgs() const
 
 int AResultSqlite::size() const
 {
-    return m_fields.empty() ? 0 : m_rows.size() / m_fields.size();
+    return m_data.rows();
 }
 
 int AResultSqlite::fields() const
@@ -804,11 +1259,6 @@ qint64 AResultSqlite::numRowsAffected() const
     return m_numRowsAffected;
 }
 
-int AResultSqlite::indexOfField(QLatin1String name) const
-{
-    return m_fields.indexOf(name);
-}
-
 QString AResultSqlite::fieldName(int column) const
 {
     return m_fields.at(column);
@@ -816,57 +1266,57 @@ QString AResultSqlite::fieldName(int column) const
 
 QVariant AResultSqlite::value(int row, int column) const
 {
-    return m_rows.at(row * m_fields.size() + column);
+    return m_data.value(row, column);
 }
 
 bool AResultSqlite::isNull(int row, int column) const
 {
-    return value(row, column).isNull();
+    return m_data.isNull(row, column);
 }
 
 bool AResultSqlite::toBool(int row, int column) const
 {
-    return value(row, column).toBool();
+    return m_data.toBool(row, column);
 }
 
 int AResultSqlite::toInt(int row, int column) const
 {
-    return value(row, column).toInt();
+    return int(m_data.toLongLong(row, column));
 }
 
 qint64 AResultSqlite::toLongLong(int row, int column) const
 {
-    return value(row, column).toLongLong();
+    return m_data.toLongLong(row, column);
 }
 
 quint64 AResultSqlite::toULongLong(int row, int column) const
 {
-    return value(row, column).toULongLong();
+    return m_data.toULongLong(row, column);
 }
 
 double AResultSqlite::toDouble(int row, int column) const
 {
-    return value(row, column).toDouble();
+    return m_data.toDouble(row, column);
 }
 
 QString AResultSqlite::toString(int row, int column) const
 {
-    return value(row, column).toString();
+    return m_data.toString(row, column);
 }
 
 std::string AResultSqlite::toStdString(int row, int column) const
 {
-    return toString(row, column).toStdString();
+    return m_data.toStdString(row, column);
 }
 
 QUuid AResultSqlite::toUuid(int row, int column) const
 {
-    return QUuid::fromString(value(row, column).toByteArray());
+    return m_data.toUuid(row, column);
 }
 
 QDate AResultSqlite::toDate(int row, int column) const
 {
-    return value(row, column).toDate();
+    return m_data.toDate(row, column);
 }
 
 QTime AResultSqlite::toTime(int row, int column) const
@@ -881,7 +1331,8 @@ QDateTime AResultSqlite::toDateTime(int row, int column) const
 
 QJsonValue AResultSqlite::toJsonValue(int row, int column) const
 {
-    auto doc = QJsonDocument::fromJson(toString(row, column).toUtf8());
+    // Text is stored as UTF-8 so it can be parsed without a round trip through QString
+    auto doc = QJsonDocument::fromJson(m_data.toByteArray(row, column));
     return doc.isObject() ? doc.object() : doc.isArray() ? doc.array() : QJsonValue{};
 }
 
@@ -892,7 +1343,717 @@ QCborValue AResultSqlite::toCborValue(int row, int column) const
 
 QByteArray AResultSqlite::toByteArray(int row, int column) const
 {
-    return value(row, column).toByteArray();
+    return m_data.toByteArray(row, column);
+}
+
+void AResultSqlite::columnInto(int column, std::span<int> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
+}
+
+void AResultSqlite::columnInto(int column, std::span<qint64> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
+}
+
+void AResultSqlite::columnInto(int column, std::span<double> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
+}
+
+void AResultSqlite::columnInto(int column, std::span<QString> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
+}
+
+QMetaType AResultSqlite::columnType(int column) const
+{
+    return m_data.columnType(column);
+}
+
+void AResultSqlite::writeJsonValue(QByteArray &out, int row, int column) const
+{
+    if (!m_data.writeJsonValue(out, row, column)) {
+        AResultPrivate::writeJsonValue(out, row, column);
+    }
+}
+
+void AResultSqlite::writeCborValue(QCborStreamWriter &writer, int row, int column) const
+{
+    if (!m_data.writeCborValue(writer, row, column)) {
+        AResultPrivate::writeCborValue(writer, row, column);
+    }
+}
+
+namespace {
+
+class OpenAdapter final : public ACoroOpenData
+{
+public:
+    void deliverOpen(bool isOpen, const QString &error) override
+    {
+        auto ref = std::move(keepAlive); // release self-ref after call
+        fn(isOpen, error);
+    }
+
+    std::function<void(bool isOpen, const QString &error)> fn;
+    std::shared_ptr<OpenAdapter> keepAlive;
+};
+
+AOpenFn openFn(std::function<void(bool isOpen, const QString &error)> fn)
+{
+    auto adapter       = std::make_shared<OpenAdapter>();
+    adapter->fn        = std::move(fn);
+    adapter->keepAlive = adapter; // self-reference
+    return AOpenFn{std::weak_ptr<ACoroOpenData>(adapter)};
+}
+
+QString withOption(const QString &connInfo, const QString &option)
+{
+    QUrl url{connInfo};
+    QUrlQuery query{url};
+    query.addQueryItem(option, {});
+    url.setQuery(query);
+    return url.toString();
+}
+
+struct SqlWord {
+    char data[12];
+    qsizetype size = 0;
+
+    bool operator==(std::string_view other) const
+    {
+        return std::string_view(data, size) == other;
+    }
+};
+
+/**
+ * A very small SQL scanner that only looks at keywords, it's meant
+ * to route statements and not to validate them.
+ */
+template <typename View>
+class SqlScanner
+{
+public:
+    SqlScanner(View sql)
+        : m_sql(sql)
+    {
+    }
+
+    char16_t at(qsizetype pos) const
+    {
+        if constexpr (std::is_same_v<View, QStringView>) {
+            return m_sql[pos].unicode();
+        } else {
+            return uchar(m_sql[pos]);
+        }
+    }
+
+    void skipSpaces()
+    {
+        while (m_pos < m_sql.size()) {
+            const char16_t c = at(m_pos);
+            if (c == u' ' || c == u'\t' || c == u'\n' || c == u'\r') {
+                ++m_pos;
+            } else if (c == u'-' && m_pos + 1 < m_sql.size() && at(m_pos + 1) == u'-') {
+                while (m_pos < m_sql.size() && at(m_pos) != u'\n') {
+                    ++m_pos;
+                }
+            } else if (c == u'/' && m_pos + 1 < m_sql.size() && at(m_pos + 1) == u'*') {
+                m_pos += 2;
+                while (m_pos + 1 < m_sql.size() && !(at(m_pos) == u'*' && at(m_pos + 1) == u'/')) {
+                    ++m_pos;
+                }
+                m_pos += 2;
+            } else {
+                break;
+            }
+        }
+    }
+
+    // Returns the next keyword in upper case, skipping anything else
+    SqlWord nextWord()
+    {
+        SqlWord word;
+        while (m_pos < m_sql.size()) {
+            skipSpaces();
+            while (m_pos < m_sql.size()) {
+                const char16_t c = at(m_pos) & ~0x20;
+                if (c < u'A' || c > u'Z') {
+                    break;
+                }
+                if (word.size < qsizetype(sizeof(word.data))) {
+                    word.data[word.size] = char(c);
+                }
+                ++word.size;
+                ++m_pos;
+            }
+            if (word.size) {
+                if (word.size > qsizetype(sizeof(word.data))) {
+                    word.size = 0;
+                    continue;
+                }
+                break;
+            }
+            ++m_pos;
+        }
+        return word;
+    }
+
+    // True if there is anything but spaces after the first ';'
+    bool hasMoreStatements()
+    {
+        while (m_pos < m_sql.size() && at(m_pos) != u';') {
+            ++m_pos;
+        }
+        ++m_pos;
+        skipSpaces();
+        return m_pos < m_sql.size();
+    }
+
+    qsizetype m_pos = 0;
+    View m_sql;
+};
+
+/**
+ * Delivers the results of a connection to a function, keeping itself alive
+ * until the last result set.
+ */
+class AResultHook final : public ACoroResult
+{
+public:
+    explicit AResultHook(std::function<void(AResult &result)> fn)
+        : m_fn{std::move(fn)}
+    {
+    }
+
+    static ACoroDataRef create(std::function<void(AResult &result)> fn)
+    {
+        auto hook    = std::make_shared<AResultHook>(std::move(fn));
+        hook->m_self = hook;
+        return ACoroDataRef{std::weak_ptr<ACoroResult>{hook}};
+    }
+
+    void deliver(AResult &result) override
+    {
+        // Released once this function returns
+        auto self = result.lastResultSet() ? std::move(m_self) : m_self;
+        m_fn(result);
+    }
+
+private:
+    std::function<void(AResult &result)> m_fn;
+    std::shared_ptr<AResultHook> m_self;
+};
+
+template <typename View, typename Route>
+Route routeSql(View sql, bool multiple)
+{
+    SqlScanner<View> scanner{sql};
+    scanner.skipSpaces();
+
+    const SqlWord first = scanner.nextWord();
+    if (multiple && SqlScanner<View>{sql}.hasMoreStatements()) {
+        return Route::Writer;
+    }
+
+    if (first == "SELECT" || first == "VALUES" || first == "EXPLAIN") {
+        return Route::Reader;
+    } else if (first == "WITH") {
+        // A CTE can end in a data changing statement
+        for (SqlWord word = scanner.nextWord(); word.size; word = scanner.nextWord()) {
+            if (word == "INSERT" || word == "UPDATE" || word == "DELETE" || word == "REPLACE") {
+                return Route::Writer;
+            }
+        }
+        return Route::Reader;
+    } else if (first == "BEGIN" || first == "SAVEPOINT" || first == "COMMIT" || first == "END" ||
+               first == "RELEASE") {
+        return Route::Transaction;
+    } else if (first == "ROLLBACK") {
+        // ROLLBACK TO only rewinds to a savepoint
+        const SqlWord next = scanner.nextWord();
+        if (next == "TRANSACTION") {
+            return scanner.nextWord() == "TO" ? Route::Writer : Route::Transaction;
+        }
+        return next == "TO" ? Route::Writer : Route::Transaction;
+    }
+    return Route::Writer;
+}
+
+} // namespace
+
+ASqliteWalConnections::ASqliteWalConnections(const QString &connInfo,
+                                             int readers,
+                                             QThreadPool *pool)
+    : m_writer{std::make_shared<ADriverSqlite>(withOption(connInfo, u"WAL"_s), pool)}
+{
+    const QString readerInfo = withOption(connInfo, u"READONLY"_s);
+    for (int i = 0; i < readers; ++i) {
+        m_readers.emplace_back(std::make_shared<ADriverSqlite>(readerInfo, pool));
+    }
+}
+
+void ASqliteWalConnections::open(std::function<void(bool, const QString &)> cb)
+{
+    if (m_state == ADatabase::State::Connected) {
+        cb(true, {});
+        return;
+    }
+
+    m_openCallbacks.emplace_back(std::move(cb));
+    if (m_state == ADatabase::State::Connecting) {
+        return;
+    }
+    m_state = ADatabase::State::Connecting;
+
+    // Readers are only opened once the writer has switched the file to WAL mode
+    std::weak_ptr<ASqliteWalConnections> self = weak_from_this();
+    m_writer->open(m_writer, nullptr, openFn([self](bool isOpen, const QString &error) {
+        auto connections = self.lock();
+        if (!connections) {
+            return;
+        }
+
+        if (!isOpen || connections->m_readers.empty()) {
+            connections->opened(isOpen, error);
+            return;
+        }
+
+        auto pending      = std::make_shared<qsizetype>(connections->m_readers.size());
+        auto failed       = std::make_shared<std::optional<QString>>();
+        auto readerOpened = [self, pending, failed](bool isOpen, const QString &error) {
+            if (!isOpen && !failed->has_value()) {
+                *failed = error;
+            }
+
+            auto connections = self.lock();
+            if (--*pending == 0 && connections) {
+                connections->opened(!failed->has_value(), failed->value_or(QString{}));
+            }
+        };
+        for (const auto &reader : connections->m_readers) {
+            reader->open(reader, nullptr, openFn(readerOpened));
+        }
+    }));
+}
+
+ADatabase::State ASqliteWalConnections::state() const
+{
+    return m_state;
+}
+
+void ASqliteWalConnections::opened(bool isOpen, const QString &error)
+{
+    m_state = isOpen ? ADatabase::State::Connected : ADatabase::State::Disconnected;
+
+    const auto callbacks = std::exchange(m_openCallbacks, {});
+    for (const auto &cb : callbacks) {
+        cb(isOpen, error);
+    }
+}
+
+std::shared_ptr<ADriverSqlite> ASqliteWalConnections::reader() const
+{
+    if (m_readers.empty()) {
+        return m_writer;
+    }
+
+    auto ret = std::ranges::min_element(m_readers, {}, [](const auto &reader) {
+        return reader->queueSize();
+    });
+    return *ret;
+}
+
+std::shared_ptr<ADriverSqlite> ASqliteWalConnections::writer() const
+{
+    return m_writer;
+}
+
+bool ASqliteWalConnections::ownsWriter(const ADriverSqliteWal *driver) const
+{
+    return m_owner == driver;
+}
+
+bool ASqliteWalConnections::writerLocked(const ADriverSqliteWal *driver) const
+{
+    return m_owner && m_owner != driver;
+}
+
+void ASqliteWalConnections::lockWriter(ADriverSqliteWal *driver)
+{
+    m_owner = driver;
+}
+
+void ASqliteWalConnections::unlockWriter(ADriverSqliteWal *driver)
+{
+    if (m_owner != driver) {
+        return;
+    }
+    m_owner = nullptr;
+
+    // Statements might start a new transaction and be deferred again
+    auto pending = std::exchange(m_pending, {});
+    while (!pending.empty()) {
+        auto fn = std::move(pending.front());
+        pending.pop_front();
+        fn();
+    }
+}
+
+void ASqliteWalConnections::defer(std::function<void()> fn)
+{
+    m_pending.emplace_back(std::move(fn));
+}
+
+int ASqliteWalConnections::queueSize() const
+{
+    int ret = m_writer->queueSize() + int(m_pending.size());
+    for (const auto &reader : m_readers) {
+        ret += reader->queueSize();
+    }
+    return ret;
+}
+
+ADriverSqliteWal::ADriverSqliteWal(const QString &connInfo,
+                                   std::shared_ptr<ASqliteWalConnections> connections)
+    : ADriver{connInfo}
+    , m_connections{std::move(connections)}
+{
+}
+
+ADriverSqliteWal::~ADriverSqliteWal()
+{
+    if (m_connections->ownsWriter(this)) {
+        auto writer = m_connections->writer();
+        writer->exec(writer, u8"ROLLBACK", nullptr, {});
+        m_connections->unlockWriter(this);
+    }
+}
+
+QString ADriverSqliteWal::driverName() const
+{
+    return u"sqlite"_s;
+}
+
+bool ADriverSqliteWal::isValid() const
+{
+    return true;
+}
+
+void ADriverSqliteWal::open(const std::shared_ptr<ADriver> &driver, QObject *receiver, AOpenFn cb)
+{
+    if (m_state == ADatabase::State::Connected) {
+        if (cb) {
+            cb(true, {});
+        }
+        return;
+    }
+
+    setState(ADatabase::State::Connecting, {});
+
+    std::optional<QPointer<QObject>> receiverPtr;
+    if (receiver) {
+        receiverPtr = receiver;
+    }
+
+    m_connections->open([driver, receiverPtr, cb](bool isOpen, const QString &error) {
+        auto self = static_cast<ADriverSqliteWal *>(driver.get());
+        if (isOpen) {
+            self->setState(ADatabase::State::Connected, {});
+        } else {
+            self->setState(ADatabase::State::Disconnected, error);
+        }
+
+        if (!receiverPtr.has_value() || !receiverPtr->isNull()) {
+            if (cb) {
+                cb(isOpen, error);
+            }
+        }
+    });
+}
+
+bool ADriverSqliteWal::isOpen() const
+{
+    return m_state == ADatabase::State::Connected;
+}
+
+void ADriverSqliteWal::setState(ADatabase::State state, const QString &status)
+{
+    m_state = state;
+    if (m_stateChangedCb &&
+        (!m_stateChangedReceiver.has_value() || !m_stateChangedReceiver->isNull())) {
+        m_stateChangedCb(state, status);
+    }
+}
+
+ADatabase::State ADriverSqliteWal::state() const
+{
+    return m_state;
+}
+
+void ADriverSqliteWal::onStateChanged(QObject *receiver,
+                                      std::function<void(ADatabase::State, const QString &)> cb)
+{
+    m_stateChangedCb = cb;
+    if (receiver) {
+        m_stateChangedReceiver = receiver;
+    }
+}
+
+void ADriverSqliteWal::begin(const std::shared_ptr<ADriver> &db, QObject *receiver, ACoroDataRef cb)
+{
+    exec(db, u8"BEGIN", receiver, std::move(cb));
+}
+
+void ADriverSqliteWal::commit(const std::shared_ptr<ADriver> &db,
+                              QObject *receiver,
+                              ACoroDataRef cb)
+{
+    exec(db, u8"COMMIT", receiver, std::move(cb));
+}
+
+void ADriverSqliteWal::rollback(const std::shared_ptr<ADriver> &db,
+                                QObject *receiver,
+                                ACoroDataRef cb)
+{
+    exec(db, u8"ROLLBACK", receiver, std::move(cb));
+}
+
+void ADriverSqliteWal::exec(const std::shared_ptr<ADriver> &db,
+                            QUtf8StringView query,
+                            QObject *receiver,
+                            ACoroDataRef cb)
+{
+    const Route route = ADriverSqliteWal::route(QByteArrayView(query.data(), query.size()), true);
+    if (auto target = connection(route)) {
+        cb = transactionResult(db, route, receiver, std::move(cb));
+        target->exec(target, query, receiver, std::move(cb));
+        return;
+    }
+
+    defer(receiver, [db, sql = query.toString(), cb](QObject *receiver) {
+        db->exec(db, QStringView(sql), receiver, cb);
+    });
+}
+
+void ADriverSqliteWal::exec(const std::shared_ptr<ADriver> &db,
+                            QStringView query,
+                            QObject *receiver,
+                            ACoroDataRef cb)
+{
+    const Route route = ADriverSqliteWal::route(query, true);
+    if (auto target = connection(route)) {
+        cb = transactionResult(db, route, receiver, std::move(cb));
+        target->exec(target, query, receiver, std::move(cb));
+        return;
+    }
+
+    defer(receiver, [db, sql = query.toString(), cb](QObject *receiver) {
+        db->exec(db, QStringView(sql), receiver, cb);
+    });
+}
+
+void ADriverSqliteWal::exec(const std::shared_ptr<ADriver> &db,
+                            QUtf8StringView query,
+                            const QVariantList &params,
+                            QObject *receiver,
+                            ACoroDataRef cb)
+{
+    const Route route = ADriverSqliteWal::route(QByteArrayView(query.data(), query.size()), false);
+    if (auto target = connection(route)) {
+        cb = transactionResult(db, route, receiver, std::move(cb));
+        target->exec(target, query, params, receiver, std::move(cb));
+        return;
+    }
+
+    defer(receiver, [db, sql = query.toString(), params, cb](QObject *receiver) {
+        db->exec(db, QStringView(sql), params, receiver, cb);
+    });
+}
+
+void ADriverSqliteWal::exec(const std::shared_ptr<ADriver> &db,
+                            QStringView query,
+                            const QVariantList &params,
+                            QObject *receiver,
+                            ACoroDataRef cb)
+{
+    const Route route = ADriverSqliteWal::route(query, false);
+    if (auto target = connection(route)) {
+        cb = transactionResult(db, route, receiver, std::move(cb));
+        target->exec(target, query, params, receiver, std::move(cb));
+        return;
+    }
+
+    defer(receiver, [db, sql = query.toString(), params, cb](QObject *receiver) {
+        db->exec(db, QStringView(sql), params, receiver, cb);
+    });
+}
+
+void ADriverSqliteWal::exec(const std::shared_ptr<ADriver> &db,
+                            const APreparedQuery &query,
+                            const QVariantList &params,
+                            QObject *receiver,
+                            ACoroDataRef cb)
+{
+    const Route route = ADriverSqliteWal::route(QByteArrayView(query.query()), false);
+    if (auto target = connection(route)) {
+        cb = transactionResult(db, route, receiver, std::move(cb));
+        target->exec(target, query, params, receiver, std::move(cb));
+        return;
+    }
+
+    defer(receiver, [db, query, params, cb](QObject *receiver) {
+        db->exec(db, query, params, receiver, cb);
+    });
+}
+
+void ADriverSqliteWal::execBatch(const std::shared_ptr<ADriver> &db,
+                                 QStringView query,
+                                 const QList<QVariantList> &rows,
+                                 QObject *receiver,
+                                 ACoroDataRef cb)
+{
+    if (auto target = connection(Route::Writer)) {
+        target->execBatch(target, query, rows, receiver, std::move(cb));
+        return;
+    }
+
+    defer(receiver, [db, sql = query.toString(), rows, cb](QObject *receiver) {
+        db->execBatch(db, QStringView(sql), rows, receiver, cb);
+    });
+}
+
+void ADriverSqliteWal::execBatch(const std::shared_ptr<ADriver> &db,
+                                 QUtf8StringView query,
+                                 const QList<QVariantList> &rows,
+                                 QObject *receiver,
+                                 ACoroDataRef cb)
+{
+    if (auto target = connection(Route::Writer)) {
+        target->execBatch(target, query, rows, receiver, std::move(cb));
+        return;
+    }
+
+    defer(receiver, [db, sql = query.toString(), rows, cb](QObject *receiver) {
+        db->execBatch(db, QStringView(sql), rows, receiver, cb);
+    });
+}
+
+void ADriverSqliteWal::setLastQuerySingleRowMode()
+{
+    if (auto target = m_lastConnection.lock()) {
+        target->setLastQuerySingleRowMode();
+    }
+}
+
+int ADriverSqliteWal::queueSize() const
+{
+    return m_connections->queueSize();
+}
+
+ADriverSqliteWal::Route ADriverSqliteWal::route(QByteArrayView query, bool multiple)
+{
+    return routeSql<QByteArrayView, Route>(query, multiple);
+}
+
+ADriverSqliteWal::Route ADriverSqliteWal::route(QStringView query, bool multiple)
+{
+    return routeSql<QStringView, Route>(query, multiple);
+}
+
+std::shared_ptr<ADriverSqlite> ADriverSqliteWal::connection(Route route)
+{
+    // Deferred statements are not streamed, they run after the caller returns
+    m_lastConnection.reset();
+
+    // Inside a transaction reads must see the uncommitted changes
+    if (route == Route::Reader && !m_connections->ownsWriter(this)) {
+        auto reader      = m_connections->reader();
+        m_lastConnection = reader;
+        return reader;
+    }
+
+    if (m_connections->writerLocked(this)) {
+        return {};
+    }
+
+    if (route == Route::Transaction) {
+        m_connections->lockWriter(this);
+    }
+    auto writer      = m_connections->writer();
+    m_lastConnection = writer;
+    return writer;
+}
+
+/**
+ * Statements that might start or end a transaction run without \a receiver, so
+ * that their result always reaches transactionFinished(), it is delivered to \a cb
+ * only if the receiver is still alive.
+ */
+ACoroDataRef ADriverSqliteWal::transactionResult(const std::shared_ptr<ADriver> &db,
+                                                 Route route,
+                                                 QObject *&receiver,
+                                                 ACoroDataRef cb)
+{
+    if (route != Route::Transaction) {
+        return cb;
+    }
+
+    std::optional<QPointer<QObject>> receiverPtr;
+    if (receiver) {
+        receiverPtr = receiver;
+        receiver    = nullptr;
+    }
+
+    ++m_pendingTransactions;
+    std::weak_ptr<ADriver> driver = db;
+    return AResultHook::create([driver, receiverPtr, cb](AResult &result) {
+        if (auto db = driver.lock()) {
+            static_cast<ADriverSqliteWal *>(db.get())->transactionFinished();
+        }
+
+        if (!receiverPtr.has_value() || !receiverPtr->isNull()) {
+            cb.deliverResult(result);
+        }
+    });
+}
+
+/**
+ * The writer is locked when a statement that might start or end a transaction is
+ * queued. It is only unlocked once the writer reports autocommit after the last of
+ * them, so a failed BEGIN releases it, a failed COMMIT keeps it and a transaction
+ * queued right after a COMMIT keeps it as well.
+ */
+void ADriverSqliteWal::transactionFinished()
+{
+    if (--m_pendingTransactions == 0 && m_connections->writer()->autocommit()) {
+        m_connections->unlockWriter(this);
+    }
+}
+
+void ADriverSqliteWal::defer(QObject *receiver, std::function<void(QObject *)> fn)
+{
+    std::optional<QPointer<QObject>> receiverPtr;
+    if (receiver) {
+        receiverPtr = receiver;
+    }
+
+    m_connections->defer([receiverPtr, fn = std::move(fn)] {
+        if (!receiverPtr.has_value()) {
+            fn(nullptr);
+        } else if (!receiverPtr->isNull()) {
+            fn(receiverPtr->data());
+        }
+    });
 }
 
 } // namespace ASql
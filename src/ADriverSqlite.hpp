@@ -1,24 +1,32 @@
 #ifndef ADRIVERSQLITE_HPP
 #define ADRIVERSQLITE_HPP
 
+#include "acolumnardata.h"
 #include "adriver.h"
 #include "apreparedquery.h"
 #include "aresult.h"
+#include "aspscqueue.h"
+#include "astrand.h"
 #include "sqlite3.h"
 
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <list>
+#include <mutex>
 #include <optional>
 
 #include <QHash>
-#include <QMutex>
 #include <QPointer>
-#include <QQueue>
+#include <QSemaphore>
 #include <QThread>
 
 using namespace std::chrono_literals;
 
 namespace ASql {
 
+struct UnlockNotification;
+
 class AResultSqlite final : public AResultPrivate
 {
 public:
@@ -36,7 +44,6 @@ public:
     int fields() const override;
     qint64 numRowsAffected() const override;
 
-    int indexOfField(QLatin1String name) const override;
     QString fieldName(int column) const override;
     inline QVariant value(int row, int column) const override;
 
@@ -56,15 +63,26 @@ public:
     QCborValue toCborValue(int row, int column) const final;
     QByteArray toByteArray(int row, int column) const override;
 
+    void columnInto(int column, std::span<int> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<qint64> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<double> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<QString> out, std::span<quint64> nulls) const override;
+
+    QMetaType columnType(int column) const override;
+    void writeJsonValue(QByteArray &out, int row, int column) const override;
+    void writeCborValue(QCborStreamWriter &writer, int row, int column) const override;
+
     inline void processResult();
 
     QByteArray m_query;
     QVariantList m_queryArgs;
-    QVariantList m_rows;
+    AColumnarData m_data;
     std::optional<QString> m_error;
     QStringList m_fields;
     qint64 m_numRowsAffected = -1;
     bool m_lastResultSet     = true;
+    // No transaction was open on the connection after the statement ran
+    bool m_autocommit = true;
 };
 
 struct OpenPromise {
@@ -74,9 +92,13 @@ struct OpenPromise {
 
 struct QueryPromise {
     std::optional<APreparedQuery> preparedQuery;
+    QList<QVariantList> batch;
     ACoroDataRef cb;
     std::shared_ptr<AResultSqlite> result;
     std::optional<QPointer<QObject>> receiver;
+    QMetaObject::Connection receiverDestroyed;
+    quint64 id    = 0;
+    bool streamed = false;
 };
 
 class ASqliteThread final : public QThread
@@ -86,8 +108,14 @@ public:
     ASqliteThread(const QString &connInfo);
     ~ASqliteThread();
 
-    QMutex m_promisesMutex;
-    QQueue<ASql::QueryPromise> m_promisesReady;
+    ASpscQueue<ASql::QueryPromise> m_promisesReady;
+    // Streamed batches not yet consumed by the owner thread
+    QSemaphore m_batchSlots{4};
+    std::atomic<quint64> m_singleRowQuery = 0;
+    std::atomic<bool> m_closing           = false;
+
+    // Called from the owner thread, id 0 interrupts any running query
+    void interrupt(quint64 id);
 
 public Q_SLOTS:
     void open();
@@ -102,6 +130,7 @@ public Q_SLOTS:
     void query(ASql::QueryPromise promise);
     void queryPrepared(ASql::QueryPromise promise);
     void queryExec(ASql::QueryPromise promise);
+    void queryBatch(ASql::QueryPromise promise);
 
 Q_SIGNALS:
     void openned(bool isOpen, QString error);
@@ -109,20 +138,52 @@ Q_SIGNALS:
 
 private:
     std::shared_ptr<sqlite3_stmt> prepare(QueryPromise &promise, int flags);
+    void enqueueAndSignal(QueryPromise &promise);
+    bool stepRows(QueryPromise &promise, sqlite3_stmt *stmt);
+    bool enqueueBatch(QueryPromise &promise, AColumnarData &rows);
+    bool start(QueryPromise &promise);
+    void finish();
+    bool interrupted() const;
+    bool timedOut() const;
+    std::chrono::steady_clock::time_point lockDeadline();
+    std::shared_ptr<sqlite3_stmt> prepareCached(QueryPromise &promise);
+    void releaseCached(const QByteArray &query, sqlite3_stmt *stmt);
     static int busyHandler(void *data, int retry_count);
+    static int progressHandler(void *data);
+    int step(sqlite3_stmt *stmt);
+    bool waitForUnlock(int res);
+
+    using StatementCache = std::list<std::pair<QByteArray, std::shared_ptr<sqlite3_stmt>>>;
 
     QHash<int, std::shared_ptr<sqlite3_stmt>> m_preparedQueries;
+    // Most recently used ad-hoc statements first
+    StatementCache m_statementCache;
+    QHash<QByteArray, StatementCache::iterator> m_statementCacheIndex;
     QString m_uri;
-    sqlite3 *m_db                              = nullptr;
-    std::chrono::milliseconds m_busyRetrySleep = 100ms;
-    int m_busyRetries                          = 1;
+    sqlite3 *m_db = nullptr;
+    // Guards m_runningQuery so that sqlite3_interrupt() only hits the query it targets
+    std::mutex m_runningMutex;
+    quint64 m_runningQuery = 0;
+    std::optional<QPointer<QObject>> m_runningReceiver;
+    // Set while waiting for a shared cache lock, so interrupt() can wake it up
+    UnlockNotification *m_unlockNotification = nullptr;
+    std::chrono::steady_clock::time_point m_deadline;
+    std::chrono::milliseconds m_queryTimeout = 0ms;
+    // BUSY_TIMEOUT deadline for the locks of the running query, set on its first wait
+    std::optional<std::chrono::steady_clock::time_point> m_lockDeadline;
+    std::chrono::milliseconds m_busyTimeout    = 5s;
+    std::chrono::milliseconds m_busyRetrySleep = 1ms;
+    std::chrono::milliseconds m_busyMaxSleep   = 100ms;
+    int m_busyRetries                          = 0;
+    int m_statementCacheSize                   = 32;
+    int m_batchRows                            = 256;
 };
 
 class ADriverSqlite final : public ADriver
 {
     Q_OBJECT
 public:
-    ADriverSqlite(const QString &connInfo);
+    ADriverSqlite(const QString &connInfo, QThreadPool *pool = nullptr);
     virtual ~ADriverSqlite();
 
     QString driverName() const override;
@@ -131,6 +192,9 @@ public:
     void open(const std::shared_ptr<ADriver> &driver, QObject *receiver, AOpenFn cb) override;
     bool isOpen() const override;
 
+    // sqlite3_get_autocommit() after the statement whose result was delivered last
+    bool autocommit() const;
+
     void setState(ADatabase::State state, const QString &status);
     ADatabase::State state() const override;
     void onStateChanged(
@@ -167,6 +231,17 @@ public:
               QObject *receiver,
               ACoroDataRef cb) override;
 
+    void execBatch(const std::shared_ptr<ADriver> &db,
+                   QStringView query,
+                   const QList<QVariantList> &rows,
+                   QObject *receiver,
+                   ACoroDataRef cb) override;
+    void execBatch(const std::shared_ptr<ADriver> &db,
+                   QUtf8StringView query,
+                   const QList<QVariantList> &rows,
+                   QObject *receiver,
+                   ACoroDataRef cb) override;
+
     void setLastQuerySingleRowMode() override;
 
     bool enterPipelineMode(std::chrono::milliseconds timeout) override;
@@ -188,19 +263,154 @@ public:
                                      const QString &name) override;
 
 private:
+    // Runs a worker method on the connection thread or on the strand
+    template <typename Method, typename... Args>
+    void dispatch(Method method, Args... args);
+    void setupCheckReceiver(QueryPromise &promise, QObject *receiver);
+
     std::optional<QPointer<QObject>> m_stateChangedReceiver;
     std::function<void(ADatabase::State, const QString &)> m_stateChangedCb;
     std::shared_ptr<ADriver> selfDriver;
     ASqliteThread m_worker;
     QThread m_thread;
+    std::unique_ptr<AStrand> m_strand;
     ADatabase::State m_state  = ADatabase::State::Disconnected;
+    quint64 m_lastQueryId     = 0;
     int m_pipelineSync        = 0;
     int m_queueSize           = 0;
+    bool m_autocommit         = true;
     bool m_flush              = false;
     bool m_queryRunning       = false;
     bool m_notificationPtrSet = false;
 };
 
+class ADriverSqliteWal;
+
+/*!
+ * A single writer and N read-only connections to the same WAL mode database file,
+ * shared by every ADriverSqliteWal created by the same factory.
+ */
+class ASqliteWalConnections : public std::enable_shared_from_this<ASqliteWalConnections>
+{
+public:
+    ASqliteWalConnections(const QString &connInfo, int readers, QThreadPool *pool);
+
+    void open(std::function<void(bool isOpen, const QString &error)> cb);
+    ADatabase::State state() const;
+
+    std::shared_ptr<ADriverSqlite> reader() const;
+    std::shared_ptr<ADriverSqlite> writer() const;
+
+    // A driver inside a transaction owns the writer until it commits or rolls back
+    bool ownsWriter(const ADriverSqliteWal *driver) const;
+    bool writerLocked(const ADriverSqliteWal *driver) const;
+    void lockWriter(ADriverSqliteWal *driver);
+    void unlockWriter(ADriverSqliteWal *driver);
+    void defer(std::function<void()> fn);
+
+    int queueSize() const;
+
+private:
+    void opened(bool isOpen, const QString &error);
+
+    std::vector<std::function<void(bool isOpen, const QString &error)>> m_openCallbacks;
+    std::deque<std::function<void()>> m_pending;
+    std::shared_ptr<ADriverSqlite> m_writer;
+    std::vector<std::shared_ptr<ADriverSqlite>> m_readers;
+    ADriverSqliteWal *m_owner = nullptr;
+    ADatabase::State m_state  = ADatabase::State::Disconnected;
+};
+
+/*!
+ * Runs read only statements on a reader connection and everything else,
+ * including transactions, on the writer connection of ASqliteWalConnections.
+ */
+class ADriverSqliteWal final : public ADriver
+{
+    Q_OBJECT
+public:
+    ADriverSqliteWal(const QString &connInfo, std::shared_ptr<ASqliteWalConnections> connections);
+    virtual ~ADriverSqliteWal();
+
+    QString driverName() const override;
+
+    bool isValid() const override;
+    void open(const std::shared_ptr<ADriver> &driver, QObject *receiver, AOpenFn cb) override;
+    bool isOpen() const override;
+
+    void setState(ADatabase::State state, const QString &status);
+    ADatabase::State state() const override;
+    void onStateChanged(
+        QObject *receiver,
+        std::function<void(ADatabase::State state, const QString &status)> cb) override;
+
+    void begin(const std::shared_ptr<ADriver> &db, QObject *receiver, ACoroDataRef cb) override;
+    void commit(const std::shared_ptr<ADriver> &db, QObject *receiver, ACoroDataRef cb) override;
+    void rollback(const std::shared_ptr<ADriver> &db, QObject *receiver, ACoroDataRef cb) override;
+
+    void exec(const std::shared_ptr<ADriver> &db,
+              QUtf8StringView query,
+              QObject *receiver,
+              ACoroDataRef cb) override;
+
+    void exec(const std::shared_ptr<ADriver> &db,
+              QStringView query,
+              QObject *receiver,
+              ACoroDataRef cb) override;
+
+    void exec(const std::shared_ptr<ADriver> &db,
+              QUtf8StringView query,
+              const QVariantList &params,
+              QObject *receiver,
+              ACoroDataRef cb) override;
+    void exec(const std::shared_ptr<ADriver> &db,
+              QStringView query,
+              const QVariantList &params,
+              QObject *receiver,
+              ACoroDataRef cb) override;
+    void exec(const std::shared_ptr<ADriver> &db,
+              const APreparedQuery &query,
+              const QVariantList &params,
+              QObject *receiver,
+              ACoroDataRef cb) override;
+
+    void execBatch(const std::shared_ptr<ADriver> &db,
+                   QStringView query,
+                   const QList<QVariantList> &rows,
+                   QObject *receiver,
+                   ACoroDataRef cb) override;
+    void execBatch(const std::shared_ptr<ADriver> &db,
+                   QUtf8StringView query,
+                   const QList<QVariantList> &rows,
+                   QObject *receiver,
+                   ACoroDataRef cb) override;
+
+    void setLastQuerySingleRowMode() override;
+
+    int queueSize() const override;
+
+private:
+    enum class Route { Reader, Writer, Transaction };
+
+    static Route route(QByteArrayView query, bool multiple);
+    static Route route(QStringView query, bool multiple);
+    std::shared_ptr<ADriverSqlite> connection(Route route);
+    ACoroDataRef transactionResult(const std::shared_ptr<ADriver> &db,
+                                   Route route,
+                                   QObject *&receiver,
+                                   ACoroDataRef cb);
+    void transactionFinished();
+    void defer(QObject *receiver, std::function<void(QObject *receiver)> fn);
+
+    std::optional<QPointer<QObject>> m_stateChangedReceiver;
+    std::function<void(ADatabase::State, const QString &)> m_stateChangedCb;
+    std::shared_ptr<ASqliteWalConnections> m_connections;
+    std::weak_ptr<ADriverSqlite> m_lastConnection;
+    ADatabase::State m_state = ADatabase::State::Disconnected;
+    // Statements that might start or end a transaction queued on the writer
+    int m_pendingTransactions = 0;
+};
+
 } // namespace ASql
 
 Q_DECLARE_METATYPE(ASql::OpenPromise)
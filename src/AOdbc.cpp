@@ -144,15 +144,15 @@ ADatabase AOdbc::database(const QUrl &connectionInfo)
 
 ADriver *AOdbc::createRawDriver() const
 {
-    return new ADriverOdbc(d->connection);
+    return new ADriverOdbc(d->connection, threadPool());
 }
 
 std::shared_ptr<ADriver> AOdbc::createDriver() const
 {
-    return std::make_shared<ADriverOdbc>(d->connection);
+    return std::make_shared<ADriverOdbc>(d->connection, threadPool());
 }
 
 ADatabase AOdbc::createDatabase() const
 {
-    return ADatabase(std::make_shared<ADriverOdbc>(d->connection));
+    return ADatabase(std::make_shared<ADriverOdbc>(d->connection, threadPool()));
 }
@@ -21,6 +21,8 @@ class AOdbcPrivate;
  * ODBC does not expose asynchronous I/O primitives, all database
  * operations are offloaded to a dedicated worker thread (the same
  * approach used by the SQLite driver), keeping the Qt event loop free.
+ * ADriverFactory::setThreadPool() allows sharing a bounded set of threads
+ * between many connections instead.
  *
  * \section Connection string format
  *
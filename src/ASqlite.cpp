@@ -8,22 +8,54 @@
 
 #include <adatabase.h>
 
+#include <QUrlQuery>
+
 using namespace ASql;
+using namespace Qt::StringLiterals;
 
 namespace ASql {
 
 class ASqlitePrivate
 {
 public:
+    std::shared_ptr<ASqliteWalConnections> connections(QThreadPool *pool) const;
+    std::shared_ptr<ADriver> createDriver(QThreadPool *pool) const;
+
     QString connection;
+    mutable std::weak_ptr<ASqliteWalConnections> walConnections;
+    int readers = 0;
 };
 
+std::shared_ptr<ASqliteWalConnections> ASqlitePrivate::connections(QThreadPool *pool) const
+{
+    // Every driver of this factory shares the same writer and readers
+    auto ret = walConnections.lock();
+    if (!ret) {
+        ret            = std::make_shared<ASqliteWalConnections>(connection, readers, pool);
+        walConnections = ret;
+    }
+    return ret;
+}
+
+std::shared_ptr<ADriver> ASqlitePrivate::createDriver(QThreadPool *pool) const
+{
+    if (readers) {
+        return std::make_shared<ADriverSqliteWal>(connection, connections(pool));
+    }
+    return std::make_shared<ADriverSqlite>(connection, pool);
+}
+
 } // namespace ASql
 
 ASqlite::ASqlite(const QString &connectionInfo)
     : d(std::make_unique<ASqlitePrivate>())
 {
     d->connection = connectionInfo;
+
+    const QUrlQuery query{QUrl{connectionInfo}};
+    if (query.hasQueryItem(u"READERS"_s)) {
+        d->readers = std::max(0, query.queryItemValue(u"READERS"_s).toInt());
+    }
 }
 
 ASqlite::~ASqlite() = default;
@@ -52,17 +84,19 @@ ADatabase ASqlite::database(const QString &connectionInfo)
 
 ADriver *ASqlite::createRawDriver() const
 {
-    auto ret = new ADriverSqlite(d->connection);
+    if (d->readers) {
+        return new ADriverSqliteWal(d->connection, d->connections(threadPool()));
+    }
+    auto ret = new ADriverSqlite(d->connection, threadPool());
     return ret;
 }
 
 std::shared_ptr<ADriver> ASqlite::createDriver() const
 {
-    auto ret = std::make_shared<ADriverSqlite>(d->connection);
-    return ret;
+    return d->createDriver(threadPool());
 }
 
 ADatabase ASqlite::createDatabase() const
 {
-    return ADatabase(std::make_shared<ADriverSqlite>(d->connection));
+    return ADatabase(d->createDriver(threadPool()));
 }
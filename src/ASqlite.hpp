@@ -23,6 +23,24 @@ public:
      *
      * Example of connection info:
      * * Just a database path "sqlite:///db_path"
+     * * Caching up to 64 ad-hoc statements "sqlite:///db_path?STATEMENT_CACHE=64",
+     *   the default is 32 and 0 disables the cache
+     * * Streaming single row mode queries in batches of 1000 rows
+     *   "sqlite:///db_path?BATCH_ROWS=1000", the default is 256
+     * * A WAL mode database with 4 read-only connections "sqlite:///db_path?READERS=4",
+     *   every database created by this factory runs writes and transactions on a
+     *   single shared writer connection and read only statements on the readers
+     * * Waiting up to 10 seconds for a lock held by another connection
+     *   "sqlite:///db_path?BUSY_TIMEOUT=10000", the default is 5000, shared by all the
+     *   waits of a query. Retries sleep from BUSY_SLEEP (1ms) doubling up to BUSY_MAX_SLEEP
+     *   (100ms) with a random jitter and BUSY_RETRIES limits their number for each
+     *   statement step, the default of 0 only limits the time. With SHAREDCACHE a
+     *   statement blocked by a table lock waits for the writer to finish if SQLite was
+     *   built with SQLITE_ENABLE_UNLOCK_NOTIFY
+     * * Interrupting queries running for more than 30 seconds
+     *   "sqlite:///db_path?QUERY_TIMEOUT=30000", the default of 0 disables it. A query
+     *   is also interrupted when its receiver is destroyed, as SQLite documents an
+     *   interrupted write inside a transaction may roll back the whole transaction
      */
     ASqlite(const QString &connectionInfo);
     ~ASqlite();
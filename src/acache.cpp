@@ -5,22 +5,197 @@
 
 #include "acache.h"
 
+#include "acolumnarresult.h"
 #include "acoroexpected.h"
 #include "adatabase.h"
 #include "apool.h"
 #include "aresult.h"
 
+#include <array>
+#include <mutex>
 #include <optional>
 
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
 #include <QLoggingCategory>
 #include <QPointer>
+#include <QRandomGenerator>
+#include <QSaveFile>
+#include <QTimer>
+#include <QUuid>
 
 Q_LOGGING_CATEGORY(ASQL_CACHE, "asql.cache", QtWarningMsg)
 
 using namespace std::chrono;
 
+namespace {
+
+constexpr char snapshotMagic[]    = "ASQLSNAP";
+constexpr quint32 snapshotVersion = 2;
+
+// Resolution of the expiry timing wheel and max entries expired per event loop slice
+constexpr milliseconds expiryTick = 100ms;
+constexpr size_t expirySliceSize  = 512;
+
+} // namespace
+
 namespace ASql {
 
+// Keeps a snapshot file mapped while any result restored from it is alive
+class ACacheSnapshotFile
+{
+public:
+    ~ACacheSnapshotFile()
+    {
+        if (data) {
+            file.unmap(data);
+        }
+    }
+
+    QFile file;
+    uchar *data = nullptr;
+};
+
+// Keeps the error of a failed fetch so it can be cached and delivered
+class ACacheErrorResult final : public AResultPrivate
+{
+public:
+    ACacheErrorResult(const QString &query, const QVariantList &args, const QString &error)
+        : m_query(query.toUtf8())
+        , m_queryArgs(args)
+        , m_error(error)
+    {
+    }
+
+    bool lastResultSet() const final { return true; }
+    bool hasError() const final { return true; }
+    QString errorString() const final { return m_error; }
+
+    QByteArray query() const final { return m_query; }
+    QVariantList queryArgs() const final { return m_queryArgs; }
+
+    int size() const final { return 0; }
+    int fields() const final { return 0; }
+    qint64 numRowsAffected() const final { return -1; }
+
+    QString fieldName(int column) const final { return {}; }
+    QVariant value(int row, int column) const final { return {}; }
+
+    bool isNull(int row, int column) const final { return true; }
+    bool toBool(int row, int column) const final { return false; }
+    int toInt(int row, int column) const final { return 0; }
+    qint64 toLongLong(int row, int column) const final { return 0; }
+    quint64 toULongLong(int row, int column) const final { return 0; }
+    double toDouble(int row, int column) const final { return 0; }
+    QString toString(int row, int column) const final { return {}; }
+    std::string toStdString(int row, int column) const final { return {}; }
+    QUuid toUuid(int row, int column) const final { return {}; }
+    QDate toDate(int row, int column) const final { return {}; }
+    QTime toTime(int row, int column) const final { return {}; }
+    QDateTime toDateTime(int row, int column) const final { return {}; }
+    QJsonValue toJsonValue(int row, int column) const final { return {}; }
+    QCborValue toCborValue(int row, int column) const final { return {}; }
+    QByteArray toByteArray(int row, int column) const final { return {}; }
+
+private:
+    QByteArray m_query;
+    QVariantList m_queryArgs;
+    QString m_error;
+};
+
+class ACacheSnapshotResult final : public AResultPrivate
+{
+public:
+    bool lastResultSet() const final { return true; }
+    bool hasError() const final { return false; }
+    QString errorString() const final { return {}; }
+
+    QByteArray query() const final { return m_query; }
+    QVariantList queryArgs() const final { return m_queryArgs; }
+
+    int size() const final { return m_size; }
+    int fields() const final { return m_fields.size(); }
+    qint64 numRowsAffected() const final { return m_numRowsAffected; }
+
+    QString fieldName(int column) const final { return m_fields.at(column); }
+    QVariant value(int row, int column) const final
+    {
+        return rows().at(row * m_fields.size() + column);
+    }
+
+    bool isNull(int row, int column) const final { return value(row, column).isNull(); }
+    bool toBool(int row, int column) const final { return value(row, column).toBool(); }
+    int toInt(int row, int column) const final { return value(row, column).toInt(); }
+    qint64 toLongLong(int row, int column) const final
+    {
+        return value(row, column).toLongLong();
+    }
+    quint64 toULongLong(int row, int column) const final
+    {
+        return value(row, column).toULongLong();
+    }
+    double toDouble(int row, int column) const final { return value(row, column).toDouble(); }
+    QString toString(int row, int column) const final { return value(row, column).toString(); }
+    std::string toStdString(int row, int column) const final
+    {
+        return toString(row, column).toStdString();
+    }
+    QUuid toUuid(int row, int column) const final { return value(row, column).toUuid(); }
+    QDate toDate(int row, int column) const final { return value(row, column).toDate(); }
+    QTime toTime(int row, int column) const final { return value(row, column).toTime(); }
+    QDateTime toDateTime(int row, int column) const final
+    {
+        return value(row, column).toDateTime();
+    }
+    QJsonValue toJsonValue(int row, int column) const final
+    {
+        return QJsonValue::fromVariant(value(row, column));
+    }
+    QCborValue toCborValue(int row, int column) const final
+    {
+        return QCborValue::fromVariant(value(row, column));
+    }
+    QByteArray toByteArray(int row, int column) const final
+    {
+        return value(row, column).toByteArray();
+    }
+
+    const QVariantList &rows() const
+    {
+        // Cells are only decoded from the mapped file when first needed
+        std::call_once(m_decoded, [this] {
+            QDataStream stream(m_cells);
+            stream.setVersion(QDataStream::Qt_6_5);
+            const qsizetype count = qsizetype(m_size) * m_fields.size();
+            m_rows.reserve(count);
+            for (qsizetype i = 0; i < count; ++i) {
+                QVariant cell;
+                stream >> cell;
+                m_rows.append(cell);
+            }
+            if (stream.status() != QDataStream::Ok) {
+                qWarning(ASQL_CACHE) << "Corrupted snapshot entry" << m_query.left(15);
+                m_rows = QVariantList(count);
+            }
+            m_cells.clear();
+            m_file.reset();
+        });
+        return m_rows;
+    }
+
+    QByteArray m_query;
+    QVariantList m_queryArgs;
+    QStringList m_fields;
+    qint64 m_numRowsAffected = -1;
+    int m_size               = 0;
+
+    mutable std::shared_ptr<ACacheSnapshotFile> m_file;
+    mutable QByteArray m_cells;
+    mutable QVariantList m_rows;
+    mutable std::once_flag m_decoded;
+};
+
 struct ACacheReceiverCb {
     AResultFn cb;
     QPointer<QObject> receiver;
@@ -39,8 +214,129 @@ struct ACacheValue {
     std::vector<ACacheReceiverCb> receivers;
     AResult result;
     std::optional<time_point<steady_clock>> hasResultTP;
+    std::optional<time_point<steady_clock>> expiresTP;
+    quint64 id = 0;
+};
+
+// Resumes the coroutine after delay unless context gets destroyed
+struct ACacheDelay {
+    QObject *context;
+    milliseconds delay;
+
+    bool await_ready() const noexcept { return delay <= 0ms; }
+    void await_suspend(std::coroutine_handle<> h) const
+    {
+        QTimer::singleShot(delay, context, [h] { h.resume(); });
+    }
+    void await_resume() const noexcept {}
+};
+
+struct ACacheTimer {
+    QString query;
+    quint64 id;
+    qint64 deadline;
+};
+
+/*!
+ * Hierarchical timing wheel, each level has 64 slots and each slot of a level covers a
+ * whole rotation of the level below it, timers are moved down one level at a time
+ * (cascaded) when the lower level wraps, so scheduling and expiring are O(1) per timer.
+ */
+class ACacheTimerWheel
+{
+public:
+    static constexpr int SlotBits = 6;
+    static constexpr int Slots    = 1 << SlotBits;
+    static constexpr int Levels   = 4;
+    static constexpr qint64 Mask  = Slots - 1;
+
+    void schedule(ACacheTimer timer);
+
+    // Moves the wheel up to nowTick appending due timers to expired, returns false if
+    // it stopped earlier because budget timers were already collected
+    bool advance(qint64 nowTick, std::vector<ACacheTimer> &expired, size_t budget);
+
+    [[nodiscard]] bool isEmpty() const { return m_count == 0; }
+
+private:
+    void cascade();
+
+    std::array<std::array<std::vector<ACacheTimer>, Slots>, Levels> m_slots;
+    std::vector<ACacheTimer> m_overflow;
+    qint64 m_current = 0;
+    size_t m_count   = 0;
 };
 
+void ACacheTimerWheel::schedule(ACacheTimer timer)
+{
+    timer.deadline = std::max(timer.deadline, m_current);
+    ++m_count;
+
+    for (int level = 0; level < Levels; ++level) {
+        // Same rotation of the upper level means the slot is still ahead of us
+        const int upperShift = SlotBits * (level + 1);
+        if ((timer.deadline >> upperShift) == (m_current >> upperShift)) {
+            const auto slot = (timer.deadline >> (SlotBits * level)) & Mask;
+            m_slots[level][slot].emplace_back(std::move(timer));
+            return;
+        }
+    }
+    m_overflow.emplace_back(std::move(timer));
+}
+
+bool ACacheTimerWheel::advance(qint64 nowTick, std::vector<ACacheTimer> &expired, size_t budget)
+{
+    while (true) {
+        auto &slot = m_slots[0][m_current & Mask];
+        while (!slot.empty() && expired.size() < budget) {
+            expired.emplace_back(std::move(slot.back()));
+            slot.pop_back();
+            --m_count;
+        }
+
+        if (!slot.empty() || (m_current < nowTick && expired.size() >= budget)) {
+            return false;
+        }
+
+        if (m_current >= nowTick || m_count == 0) {
+            m_current = std::max(m_current, nowTick);
+            return true;
+        }
+
+        ++m_current;
+        cascade();
+    }
+}
+
+void ACacheTimerWheel::cascade()
+{
+    if (m_current & Mask) {
+        return;
+    }
+
+    // Find the highest level that wrapped, and move its timers down starting from it
+    int level = 1;
+    while (level < Levels - 1 && ((m_current >> (SlotBits * level)) & Mask) == 0) {
+        ++level;
+    }
+
+    if (level == Levels - 1 && ((m_current >> (SlotBits * level)) & Mask) == 0) {
+        auto timers = std::exchange(m_overflow, {});
+        for (auto &timer : timers) {
+            --m_count;
+            schedule(std::move(timer));
+        }
+    }
+
+    for (; level > 0; --level) {
+        auto timers = std::exchange(m_slots[level][(m_current >> (SlotBits * level)) & Mask], {});
+        for (auto &timer : timers) {
+            --m_count;
+            schedule(std::move(timer));
+        }
+    }
+}
+
 class ACachePrivate
 {
 public:
@@ -55,7 +351,17 @@ public:
                        const QVariantList &args,
                        QObject *receiver,
                        AResultFn cb);
-    ACoroTerminator requestData(QString query, QVariantList args, QObject *receiver, AResultFn cb);
+    ACoroTerminator requestData(QString query,
+                                QVariantList args,
+                                std::chrono::milliseconds ttl,
+                                QObject *receiver,
+                                AResultFn cb);
+    void scheduleExpiry(const QString &query, ACacheValue &value, time_point<steady_clock> when);
+    [[nodiscard]] milliseconds retryDelay(int attempt) const;
+    void expireSlice();
+    void count(const QString &query, quint64 ACacheCounters::*counter, quint64 n = 1);
+    void countFetch(const QString &query, microseconds elapsed, bool error);
+    ACacheCounters &queryCounters(const QString &query);
 
     QObject *q_ptr;
     QString poolName;
@@ -70,9 +376,110 @@ public:
     // With QString that does not happen, and eventually in Qt 6.8 we
     // can use the view to do lookups.
     QMultiHash<QString, ACacheValue> cache;
-    DbSource dbSource = DbSource::Unset;
+    ACacheStatistics statistics;
+    ACachePolicy policy;
+    ACacheTimerWheel expiryWheel;
+    QTimer expiryTimer;
+    const time_point<steady_clock> expiryOrigin = steady_clock::now();
+    std::chrono::milliseconds defaultTtl{-1};
+    int maxStatisticsQueries = 1000;
+    quint64 nextId           = 0;
+    DbSource dbSource        = DbSource::Unset;
+    bool compactResults      = false;
 };
 
+void ACachePrivate::scheduleExpiry(const QString &query,
+                                   ACacheValue &value,
+                                   time_point<steady_clock> when)
+{
+    value.expiresTP = when;
+
+    // Round up so entries are never expired before their time
+    const auto elapsed = duration_cast<milliseconds>(when - expiryOrigin);
+    expiryWheel.schedule(ACacheTimer{
+        .query    = query,
+        .id       = value.id,
+        .deadline = (elapsed.count() + expiryTick.count() - 1) / expiryTick.count(),
+    });
+
+    if (!expiryTimer.isActive()) {
+        expiryTimer.start(expiryTick);
+    }
+}
+
+milliseconds ACachePrivate::retryDelay(int attempt) const
+{
+    milliseconds delay = policy.retryDelay;
+    for (int i = 0; i < attempt && delay < policy.maxRetryDelay; ++i) {
+        delay *= 2;
+    }
+    delay = std::min(delay, policy.maxRetryDelay);
+
+    // Spread retries of different entries within [delay / 2, delay]
+    const qint64 half = delay.count() / 2;
+    return milliseconds(half + QRandomGenerator::global()->bounded(half + 1));
+}
+
+void ACachePrivate::expireSlice()
+{
+    const auto now      = steady_clock::now();
+    const qint64 tick   = duration_cast<milliseconds>(now - expiryOrigin) / expiryTick;
+    std::vector<ACacheTimer> expired;
+    const bool caughtUp = expiryWheel.advance(tick, expired, expirySliceSize);
+
+    for (const ACacheTimer &timer : expired) {
+        auto it = cache.find(timer.query);
+        while (it != cache.end() && it.key() == timer.query) {
+            // Entries removed or replaced meanwhile have a different id
+            if (it->id == timer.id) {
+                qDebug(ASQL_CACHE) << "TTL expired" << timer.query.left(15) << it->args;
+                cache.erase(it);
+                count(timer.query, &ACacheCounters::expirations);
+                break;
+            }
+            ++it;
+        }
+    }
+
+    if (!caughtUp) {
+        // Let the event loop breathe before the next slice
+        expiryTimer.start(0ms);
+    } else if (!expiryWheel.isEmpty()) {
+        expiryTimer.start(expiryTick);
+    }
+}
+
+void ACachePrivate::count(const QString &query, quint64 ACacheCounters::*counter, quint64 n)
+{
+    statistics.total.*counter += n;
+    queryCounters(query).*counter += n;
+}
+
+void ACachePrivate::countFetch(const QString &query, microseconds elapsed, bool error)
+{
+    for (ACacheCounters *counters : {&statistics.total, &queryCounters(query)}) {
+        ++counters->fetches;
+        if (error) {
+            ++counters->fetchErrors;
+        }
+        counters->fetchTime += elapsed;
+        counters->maxFetchTime = std::max(counters->maxFetchTime, elapsed);
+    }
+}
+
+ACacheCounters &ACachePrivate::queryCounters(const QString &query)
+{
+    auto it = statistics.queries.find(query);
+    if (it != statistics.queries.end()) {
+        return *it;
+    }
+
+    if (statistics.queries.size() < maxStatisticsQueries) {
+        return statistics.queries[query];
+    }
+    return statistics.otherQueries;
+}
+
 bool ACachePrivate::searchOrQueue(const QString &query,
                                   std::chrono::milliseconds maxAge,
                                   const QVariantList &args,
@@ -84,16 +491,25 @@ bool ACachePrivate::searchOrQueue(const QString &query,
         auto &value = *it;
         if (value.args == args) {
             if (value.hasResultTP.has_value()) {
+                if (value.expiresTP.has_value() && value.expiresTP.value() <= steady_clock::now()) {
+                    qDebug(ASQL_CACHE) << "TTL expired" << query.left(15) << args;
+                    cache.erase(it);
+                    count(query, &ACacheCounters::expirations);
+                    break;
+                }
+
                 if (maxAge >= 0ms) {
                     const auto cutAge = steady_clock::now() - maxAge;
                     if (value.hasResultTP.value() < cutAge) {
                         qDebug(ASQL_CACHE) << "Expiring cache" << query.left(15) << args;
                         cache.erase(it);
+                        count(query, &ACacheCounters::expirations);
                         break;
                     }
                 }
 
                 qDebug(ASQL_CACHE) << "Cached query ready" << query.left(15) << args;
+                count(query, &ACacheCounters::hits);
                 if (cb) {
                     cb(value.result);
                 }
@@ -101,6 +517,7 @@ bool ACachePrivate::searchOrQueue(const QString &query,
                 qDebug(ASQL_CACHE) << "Queuing request" << query.left(15) << args;
                 // queue another request
                 value.receivers.emplace_back(ACacheReceiverCb{cb, receiver, receiver});
+                count(query, &ACacheCounters::coalesced);
             }
 
             return true;
@@ -108,11 +525,15 @@ bool ACachePrivate::searchOrQueue(const QString &query,
         ++it;
     }
 
+    count(query, &ACacheCounters::misses);
     return false;
 }
 
-ACoroTerminator
-    ACachePrivate::requestData(QString query, QVariantList args, QObject *receiver, AResultFn cb)
+ACoroTerminator ACachePrivate::requestData(QString query,
+                                           QVariantList args,
+                                           std::chrono::milliseconds ttl,
+                                           QObject *receiver,
+                                           AResultFn cb)
 {
     qCDebug(ASQL_CACHE) << "Requesting data" << query.left(15) << args << int(dbSource);
     co_yield q_ptr;
@@ -149,29 +570,72 @@ ACoroTerminator
 
     ACacheValue cacheValue;
     cacheValue.args = args;
+    cacheValue.id   = ++nextId;
     cacheValue.receivers.emplace_back(cacheReceiver);
+    const quint64 id = cacheValue.id;
 
     cache.emplace(query, std::move(cacheValue));
 
-    auto result = co_await localDb.exec(query, args, q_ptr);
-    bool found  = false;
-    auto it     = cache.constFind(query);
+    auto fetchStart = steady_clock::now();
+    auto result     = co_await localDb.exec(query, args, q_ptr);
+    bool failed     = !result.has_value();
+    countFetch(query, duration_cast<microseconds>(steady_clock::now() - fetchStart), failed);
+
+    for (int attempt = 0; failed && attempt < policy.retries; ++attempt) {
+        const milliseconds delay = retryDelay(attempt);
+        qDebug(ASQL_CACHE) << "Retrying failed request in" << delay.count() << "ms"
+                           << query.left(15) << args;
+        count(query, &ACacheCounters::retries);
+        co_await ACacheDelay{q_ptr, delay};
+
+        fetchStart = steady_clock::now();
+        result     = co_await localDb.exec(query, args, q_ptr);
+        failed     = !result.has_value();
+        countFetch(query, duration_cast<microseconds>(steady_clock::now() - fetchStart), failed);
+    }
+
+    // Failed results are delivered as an unexpected error, keep it in a result
+    const AResult fetched =
+        failed ? AResult(std::make_shared<ACacheErrorResult>(query, args, result.error()))
+               : *result;
+
+    bool found = false;
+    auto it    = cache.constFind(query);
     while (it != cache.constEnd() && it.key() == query) {
         ACacheValue &value = it.value();
-        if (value.args == args) {
-            value.result      = *result;
-            value.hasResultTP = steady_clock::now();
-
+        if (value.id == id) {
             // Copy the receivers as the callback call might invalidade the cache
             std::vector<ACacheReceiverCb> receivers = std::move(value.receivers);
             value.receivers.clear();
 
+            if (failed && !policy.cacheErrors) {
+                qDebug(ASQL_CACHE) << "Not caching failed request" << query.left(15) << args;
+                cache.erase(it);
+            } else {
+                if (compactResults && !failed) {
+                    value.result = AResult(AColumnarResult::fromResult(fetched));
+                } else {
+                    value.result = fetched;
+                }
+                value.hasResultTP = steady_clock::now();
+
+                milliseconds entryTtl = ttl;
+                if (failed) {
+                    entryTtl = policy.errorTtl.value_or(ttl);
+                } else if (fetched.size() == 0) {
+                    entryTtl = policy.emptyTtl.value_or(ttl);
+                }
+                if (entryTtl >= 0ms) {
+                    scheduleExpiry(query, value, value.hasResultTP.value() + entryTtl);
+                }
+            }
+
             qDebug(ASQL_CACHE) << "Got request data, dispatching to" << receivers.size()
                                << "receivers" << query.left(15) << args;
             for (const ACacheReceiverCb &receiverObj : receivers) {
                 qDebug(ASQL_CACHE) << "Dispatching to receiver" << receiverObj.checkReceiver
                                    << query.left(15) << args;
-                receiverObj.emitResult(*result);
+                receiverObj.emitResult(fetched);
             }
             found = true;
 
@@ -196,9 +660,17 @@ ACache::ACache(QObject *parent)
     , d_ptr(new ACachePrivate)
 {
     d_ptr->q_ptr = this;
+    d_ptr->expiryTimer.setSingleShot(true);
+    connect(&d_ptr->expiryTimer, &QTimer::timeout, this, [this] {
+        Q_D(ACache);
+        d->expireSlice();
+    });
 }
 
-ACache::~ACache() = default;
+ACache::~ACache()
+{
+    delete d_ptr;
+}
 
 void ACache::setDatabasePool(const QString &poolName)
 {
@@ -223,6 +695,7 @@ bool ACache::clear(const QString &query, const QVariantList &params)
     while (it != d->cache.constEnd() && it.key() == query) {
         if (it.value().args == params) {
             d->cache.erase(it);
+            d->count(query, &ACacheCounters::evictions);
             return true;
         }
         ++it;
@@ -246,6 +719,7 @@ bool ACache::expire(std::chrono::milliseconds maxAge,
                 ret = true;
                 // qDebug(ASQL_CACHE) << "clearing cache" << query << params;
                 d->cache.erase(it);
+                d->count(query, &ACacheCounters::expirations);
             }
             break;
         }
@@ -263,6 +737,7 @@ int ACache::expireAll(std::chrono::milliseconds maxAge)
     while (it != d->cache.end()) {
         const ACacheValue &value = *it;
         if (value.hasResultTP.has_value() && value.hasResultTP.value() < cutAge) {
+            d->count(it.key(), &ACacheCounters::expirations);
             it = d->cache.erase(it);
             ++ret;
         } else {
@@ -273,18 +748,259 @@ int ACache::expireAll(std::chrono::milliseconds maxAge)
     return ret;
 }
 
+void ACache::setDefaultTimeToLive(std::chrono::milliseconds ttl)
+{
+    Q_D(ACache);
+    d->defaultTtl = ttl;
+}
+
+std::chrono::milliseconds ACache::defaultTimeToLive() const
+{
+    Q_D(const ACache);
+    return d->defaultTtl;
+}
+
+void ACache::setCompactResults(bool enable)
+{
+    Q_D(ACache);
+    d->compactResults = enable;
+}
+
+bool ACache::compactResults() const
+{
+    Q_D(const ACache);
+    return d->compactResults;
+}
+
+void ACache::setPolicy(const ACachePolicy &policy)
+{
+    Q_D(ACache);
+    d->policy = policy;
+}
+
+ACachePolicy ACache::policy() const
+{
+    Q_D(const ACache);
+    return d->policy;
+}
+
 int ACache::size() const
 {
     Q_D(const ACache);
     return d->cache.size();
 }
 
+ACacheStatistics ACache::statistics() const
+{
+    Q_D(const ACache);
+    ACacheStatistics ret = d->statistics;
+    ret.size             = d->cache.size();
+    return ret;
+}
+
+void ACache::resetStatistics()
+{
+    Q_D(ACache);
+    d->statistics = {};
+}
+
+void ACache::setMaxStatisticsQueries(int max)
+{
+    Q_D(ACache);
+    d->maxStatisticsQueries = std::max(0, max);
+}
+
+int ACache::maxStatisticsQueries() const
+{
+    Q_D(const ACache);
+    return d->maxStatisticsQueries;
+}
+
+bool ACache::saveSnapshot(const QString &fileName) const
+{
+    Q_D(const ACache);
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning(ASQL_CACHE) << "Failed to save snapshot" << fileName << file.errorString();
+        return false;
+    }
+
+    const auto now = steady_clock::now();
+    quint32 count  = 0;
+    for (const ACacheValue &value : std::as_const(d->cache)) {
+        if (value.hasResultTP.has_value() && !value.result.hasError()) {
+            ++count;
+        }
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_5);
+    stream.writeRawData(snapshotMagic, sizeof(snapshotMagic) - 1);
+    stream << snapshotVersion << QDateTime::currentMSecsSinceEpoch() << count;
+
+    for (auto it = d->cache.cbegin(); it != d->cache.cend(); ++it) {
+        const ACacheValue &value = it.value();
+        if (!value.hasResultTP.has_value() || value.result.hasError()) {
+            continue;
+        }
+
+        const AResult &result = value.result;
+        const int rows        = result.size();
+        const int columns     = result.fields();
+        const auto age        = duration_cast<milliseconds>(now - value.hasResultTP.value());
+
+        // The entry's own time to live, from execTtl() or the policy, -1 if it never expires
+        const auto ttl = value.expiresTP.has_value()
+                             ? duration_cast<milliseconds>(*value.expiresTP - *value.hasResultTP)
+                             : -1ms;
+
+        QByteArray cells;
+        {
+            QDataStream cellsStream(&cells, QIODevice::WriteOnly);
+            cellsStream.setVersion(QDataStream::Qt_6_5);
+            for (auto row : result) {
+                for (int column = 0; column < columns; ++column) {
+                    cellsStream << row.value(column);
+                }
+            }
+        }
+
+        // Written as length and bytes, a null QByteArray would store 0xFFFFFFFF as its size
+        stream << it.key() << value.args << result.columnNames() << qint64(result.numRowsAffected())
+               << qint64(age.count()) << qint64(ttl.count()) << qint32(rows)
+               << quint32(cells.size());
+        stream.writeRawData(cells.constData(), int(cells.size()));
+    }
+
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qWarning(ASQL_CACHE) << "Failed to save snapshot" << fileName << file.errorString();
+        return false;
+    }
+
+    qDebug(ASQL_CACHE) << "Saved snapshot" << fileName << count << "entries";
+    return true;
+}
+
+int ACache::loadSnapshot(const QString &fileName, std::chrono::milliseconds maxAge)
+{
+    Q_D(ACache);
+    auto snapshot = std::make_shared<ACacheSnapshotFile>();
+    snapshot->file.setFileName(fileName);
+    if (!snapshot->file.open(QIODevice::ReadOnly)) {
+        qWarning(ASQL_CACHE) << "Failed to load snapshot" << fileName
+                             << snapshot->file.errorString();
+        return -1;
+    }
+
+    const qint64 fileSize = snapshot->file.size();
+    snapshot->data        = snapshot->file.map(0, fileSize);
+    if (!snapshot->data) {
+        qWarning(ASQL_CACHE) << "Failed to map snapshot" << fileName
+                             << snapshot->file.errorString();
+        return -1;
+    }
+
+    const auto mapped = QByteArray::fromRawData(reinterpret_cast<const char *>(snapshot->data),
+                                                fileSize);
+    constexpr qsizetype magicSize = sizeof(snapshotMagic) - 1;
+    if (!mapped.startsWith(QByteArrayView(snapshotMagic, magicSize))) {
+        qWarning(ASQL_CACHE) << "Invalid snapshot file" << fileName;
+        return -1;
+    }
+
+    QDataStream stream(mapped);
+    stream.setVersion(QDataStream::Qt_6_5);
+    stream.skipRawData(magicSize);
+
+    quint32 version;
+    qint64 savedAt;
+    quint32 count;
+    stream >> version >> savedAt >> count;
+    if (stream.status() != QDataStream::Ok || version != snapshotVersion) {
+        qWarning(ASQL_CACHE) << "Unsupported snapshot file" << fileName << version;
+        return -1;
+    }
+
+    const auto now = steady_clock::now();
+    const auto sinceSaved =
+        milliseconds(std::max<qint64>(0, QDateTime::currentMSecsSinceEpoch() - savedAt));
+    int loaded = 0;
+    for (quint32 i = 0; i < count; ++i) {
+        QString query;
+        QVariantList args;
+        QStringList fields;
+        qint64 numRowsAffected;
+        qint64 ageMs;
+        qint64 ttlMs;
+        qint32 rows;
+        quint32 cellsSize;
+        stream >> query >> args >> fields >> numRowsAffected >> ageMs >> ttlMs >> rows >>
+            cellsSize;
+        if (stream.status() != QDataStream::Ok) {
+            qWarning(ASQL_CACHE) << "Truncated snapshot file" << fileName;
+            break;
+        }
+
+        // Point to the cells inside the mapping instead of copying them
+        const qint64 cellsPos = stream.device()->pos();
+        if (cellsSize > quint64(mapped.size() - cellsPos) ||
+            stream.skipRawData(int(cellsSize)) != int(cellsSize)) {
+            qWarning(ASQL_CACHE) << "Truncated snapshot file" << fileName;
+            break;
+        }
+
+        const auto age = milliseconds(ageMs) + sinceSaved;
+        const auto ttl = milliseconds(ttlMs);
+        if ((maxAge >= 0ms && age > maxAge) || (ttl >= 0ms && age >= ttl)) {
+            qDebug(ASQL_CACHE) << "Skipping stale snapshot entry" << query.left(15) << args;
+            continue;
+        }
+
+        bool exists = false;
+        auto it     = d->cache.constFind(query);
+        while (it != d->cache.constEnd() && it.key() == query) {
+            if (it.value().args == args) {
+                exists = true;
+                break;
+            }
+            ++it;
+        }
+        if (exists) {
+            continue;
+        }
+
+        auto result               = std::make_shared<ACacheSnapshotResult>();
+        result->m_query           = query.toUtf8();
+        result->m_queryArgs       = args;
+        result->m_fields          = fields;
+        result->m_numRowsAffected = numRowsAffected;
+        result->m_size            = rows;
+        result->m_file            = snapshot;
+        result->m_cells =
+            QByteArray::fromRawData(mapped.constData() + cellsPos, qsizetype(cellsSize));
+
+        ACacheValue cacheValue;
+        cacheValue.args        = args;
+        cacheValue.result      = AResult(std::move(result));
+        cacheValue.hasResultTP = now - age;
+        cacheValue.id          = ++d->nextId;
+        auto inserted          = d->cache.emplace(query, std::move(cacheValue));
+        if (ttl >= 0ms) {
+            d->scheduleExpiry(query, *inserted, now - age + ttl);
+        }
+        ++loaded;
+    }
+
+    qDebug(ASQL_CACHE) << "Loaded snapshot" << fileName << loaded << "of" << count << "entries";
+    return loaded;
+}
+
 AExpectedResult ACache::exec(const QString &query, QObject *receiver)
 {
     Q_D(ACache);
     AExpectedResult coro(receiver);
     if (!d->searchOrQueue(query, -1ms, {}, receiver, coro.ref())) {
-        d->requestData(query, {}, receiver, coro.ref());
+        d->requestData(query, {}, d->defaultTtl, receiver, coro.ref());
     }
     return coro;
 }
@@ -294,7 +1010,7 @@ AExpectedResult ACache::exec(const QString &query, const QVariantList &args, QOb
     Q_D(ACache);
     AExpectedResult coro(receiver);
     if (!d->searchOrQueue(query, -1ms, args, receiver, coro.ref())) {
-        d->requestData(query, args, receiver, coro.ref());
+        d->requestData(query, args, d->defaultTtl, receiver, coro.ref());
     }
     return coro;
 }
@@ -305,7 +1021,7 @@ AExpectedResult
     Q_D(ACache);
     AExpectedResult coro(receiver);
     if (!d->searchOrQueue(query, maxAge, {}, receiver, coro.ref())) {
-        d->requestData(query, {}, receiver, coro.ref());
+        d->requestData(query, {}, d->defaultTtl, receiver, coro.ref());
     }
     return coro;
 }
@@ -318,7 +1034,31 @@ AExpectedResult ACache::execExpiring(const QString &query,
     Q_D(ACache);
     AExpectedResult coro(receiver);
     if (!d->searchOrQueue(query, maxAge, args, receiver, coro.ref())) {
-        d->requestData(query, args, receiver, coro.ref());
+        d->requestData(query, args, d->defaultTtl, receiver, coro.ref());
+    }
+    return coro;
+}
+
+AExpectedResult
+    ACache::execTtl(const QString &query, std::chrono::milliseconds ttl, QObject *receiver)
+{
+    Q_D(ACache);
+    AExpectedResult coro(receiver);
+    if (!d->searchOrQueue(query, -1ms, {}, receiver, coro.ref())) {
+        d->requestData(query, {}, ttl, receiver, coro.ref());
+    }
+    return coro;
+}
+
+AExpectedResult ACache::execTtl(const QString &query,
+                                std::chrono::milliseconds ttl,
+                                const QVariantList &args,
+                                QObject *receiver)
+{
+    Q_D(ACache);
+    AExpectedResult coro(receiver);
+    if (!d->searchOrQueue(query, -1ms, args, receiver, coro.ref())) {
+        d->requestData(query, args, ttl, receiver, coro.ref());
     }
     return coro;
 }
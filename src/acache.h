@@ -7,7 +7,9 @@
 #include <adatabase.h>
 #include <asql_export.h>
 #include <chrono>
+#include <optional>
 
+#include <QHash>
 #include <QObject>
 
 namespace ASql {
@@ -17,6 +19,72 @@ class ACoroExpected;
 
 using AExpectedResult = ACoroExpected<AResult>;
 
+/*!
+ * \brief ACacheCounters holds the usage counters of a cache or of a single query
+ */
+struct ACacheCounters {
+    /*! Requests answered with a cached result */
+    quint64 hits = 0;
+    /*! Requests that had to fetch data from the database */
+    quint64 misses = 0;
+    /*! Requests that waited for an identical request already being fetched */
+    quint64 coalesced = 0;
+    /*! Entries removed because they got older than the requested max age */
+    quint64 expirations = 0;
+    /*! Entries explicitly removed with \sa ACache::clear() */
+    quint64 evictions = 0;
+    /*! Database fetches that completed, including failed ones */
+    quint64 fetches = 0;
+    /*! Database fetches that returned an error */
+    quint64 fetchErrors = 0;
+    /*! Failed fetches that were retried, see \sa ACachePolicy::retries */
+    quint64 retries = 0;
+    /*! Sum of the time spent waiting for the database */
+    std::chrono::microseconds fetchTime{0};
+    /*! Slowest database fetch */
+    std::chrono::microseconds maxFetchTime{0};
+
+    [[nodiscard]] inline std::chrono::microseconds averageFetchTime() const
+    {
+        return fetches ? fetchTime / fetches : std::chrono::microseconds{0};
+    }
+};
+
+/*!
+ * \brief ACacheStatistics is a snapshot of the counters of a cache
+ */
+struct ACacheStatistics {
+    /*! Counters for all queries */
+    ACacheCounters total;
+    /*! Counters per query string, regardless of the arguments used, for up to
+     * \sa ACache::maxStatisticsQueries() distinct queries */
+    QHash<QString, ACacheCounters> queries;
+    /*! Counters of the queries that didn't fit in \a queries */
+    ACacheCounters otherQueries;
+    /*! Number of entries in the cache when the snapshot was taken */
+    int size = 0;
+};
+
+/*!
+ * \brief ACachePolicy defines how empty and failed results are cached
+ *
+ * The default policy caches everything with the time to live requested for the entry.
+ */
+struct ACachePolicy {
+    /*! Time to live of results without rows, unset uses the entry time to live */
+    std::optional<std::chrono::milliseconds> emptyTtl;
+    /*! Time to live of failed results, unset uses the entry time to live */
+    std::optional<std::chrono::milliseconds> errorTtl;
+    /*! When false failed results are delivered to the waiting requests but not stored */
+    bool cacheErrors = true;
+    /*! How many times a failed fetch is retried before the error is delivered */
+    int retries = 0;
+    /*! Delay before the first retry, doubled on each attempt with a random jitter */
+    std::chrono::milliseconds retryDelay{100};
+    /*! Upper limit of the retry delay */
+    std::chrono::milliseconds maxRetryDelay{5000};
+};
+
 class ACachePrivate;
 class ASQL_EXPORT ACache : public QObject
 {
@@ -41,12 +109,97 @@ public:
                 const QVariantList &params = {});
     int expireAll(std::chrono::milliseconds maxAge);
 
+    /*!
+     * \brief setDefaultTimeToLive sets the time to live of entries added with \sa exec()
+     *
+     * Entries with a time to live are removed once it elapses, expiration is done incrementally
+     * by a timing wheel on the thread that owns the cache, so no full scan of the cache happens.
+     * A negative value, the default, keeps the entries until they are cleared or expired.
+     *
+     * \param ttl
+     */
+    void setDefaultTimeToLive(std::chrono::milliseconds ttl);
+    [[nodiscard]] std::chrono::milliseconds defaultTimeToLive() const;
+
+    /*!
+     * \brief setCompactResults converts new results into a compact columnar storage
+     *
+     * When enabled the results are copied into an \sa AColumnarResult before being cached,
+     * releasing the driver result, this reduces memory usage considerably at the cost of
+     * the conversion. Requests waiting for the first fetch still get the driver result.
+     *
+     * \param enable
+     */
+    void setCompactResults(bool enable);
+    [[nodiscard]] bool compactResults() const;
+
+    /*!
+     * \brief setPolicy sets how empty and failed results are cached and retried
+     *
+     * Retrying happens while identical requests are waiting on the first one, so during
+     * a database outage a single query per entry reaches the database.
+     *
+     * \param policy
+     */
+    void setPolicy(const ACachePolicy &policy);
+    [[nodiscard]] ACachePolicy policy() const;
+
     /*!
      * \brief size of the cache
      * \return the number of entries in the cache
      */
     [[nodiscard]] int size() const;
 
+    /*!
+     * \brief statistics returns a copy of the cache counters
+     */
+    [[nodiscard]] ACacheStatistics statistics() const;
+
+    /*!
+     * \brief resetStatistics sets all counters back to zero
+     */
+    void resetStatistics();
+
+    /*!
+     * \brief setMaxStatisticsQueries limits the number of queries with their own counters
+     *
+     * Queries with literal values in their text are all distinct, once \p max queries are
+     * tracked new ones are only added to \sa ACacheStatistics::otherQueries, the default
+     * is 1000 and 0 disables the per query counters.
+     *
+     * \param max
+     */
+    void setMaxStatisticsQueries(int max);
+    [[nodiscard]] int maxStatisticsQueries() const;
+
+    /*!
+     * \brief saveSnapshot writes all ready, non failing cache entries to \p fileName
+     *
+     * The file stores the query, arguments, column names, typed cell data, the age and the
+     * time to live of each entry, it can be later used with \sa loadSnapshot() to warm up a
+     * fresh cache.
+     *
+     * \param fileName
+     * \return true if the snapshot was written
+     */
+    bool saveSnapshot(const QString &fileName) const;
+
+    /*!
+     * \brief loadSnapshot restores the entries saved with \sa saveSnapshot()
+     *
+     * The file is memory mapped and only the entries headers are parsed, the cell data of
+     * each entry is decoded from the mapping the first time the result is accessed.
+     * Entries older than \p maxAge, unless it's negative, or than their own time to live are
+     * skipped, entries already present in the cache are kept. Loaded entries expire when the
+     * rest of the time to live they had when saved elapses.
+     *
+     * \param fileName
+     * \param maxAge
+     * \return the number of entries loaded or -1 if the file could not be read
+     */
+    int loadSnapshot(const QString &fileName,
+                     std::chrono::milliseconds maxAge = std::chrono::milliseconds{-1});
+
     AExpectedResult exec(const QString &query, QObject *receiver = nullptr);
     AExpectedResult
         exec(const QString &query, const QVariantList &args, QObject *receiver = nullptr);
@@ -58,6 +211,16 @@ public:
                                  const QVariantList &args,
                                  QObject *receiver = nullptr);
 
+    /*!
+     * \brief execTtl same as \sa exec() but a new entry will be removed after \p ttl
+     */
+    AExpectedResult
+        execTtl(const QString &query, std::chrono::milliseconds ttl, QObject *receiver = nullptr);
+    AExpectedResult execTtl(const QString &query,
+                            std::chrono::milliseconds ttl,
+                            const QVariantList &args,
+                            QObject *receiver = nullptr);
+
 private:
     ACachePrivate *d_ptr;
 };
@@ -0,0 +1,717 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2025 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "acolumnardata.h"
+
+#include "aresult.h"
+
+#include <QCborStreamWriter>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <type_traits>
+
+using namespace ASql;
+
+namespace {
+
+inline bool testNull(const std::vector<quint64> &nulls, int row)
+{
+    return size_t(row >> 6) < nulls.size() && (nulls[row >> 6] >> (row & 63)) & 1;
+}
+
+inline void setNull(std::vector<quint64> &nulls, int row)
+{
+    if (size_t(row >> 6) >= nulls.size()) {
+        nulls.resize((row >> 6) + 1, 0);
+    }
+    nulls[row >> 6] |= quint64(1) << (row & 63);
+}
+
+// Doubles are rounded when converted to integers, as QVariant does
+template <typename T, typename V>
+inline T convertValue(V value)
+{
+    if constexpr (std::is_floating_point_v<V> && std::is_integral_v<T>) {
+        return T(qRound64(value));
+    } else {
+        return T(value);
+    }
+}
+
+// Copies the typed array of a column, handling the NULL bitmap
+template <typename T, typename V>
+void copyColumn(const std::vector<V> &values,
+                const std::vector<quint64> &columnNulls,
+                std::span<T> out,
+                std::span<quint64> nulls)
+{
+    for (size_t row = 0; row < out.size(); ++row) {
+        const bool null = testNull(columnNulls, int(row));
+        detail::setNullBit(nulls, row, null);
+        out[row] = null ? T{} : convertValue<T>(values[row]);
+    }
+}
+
+QJsonValue parseJson(QByteArrayView json)
+{
+    const auto doc = QJsonDocument::fromJson(json.toByteArray());
+    return doc.isObject() ? doc.object() : doc.isArray() ? doc.array() : QJsonValue{};
+}
+
+} // namespace
+
+void AColumnarData::reset(int columns)
+{
+    m_columns.clear();
+    m_columns.resize(columns);
+    m_rows   = 0;
+    m_column = 0;
+}
+
+int AColumnarData::columns() const
+{
+    return int(m_columns.size());
+}
+
+int AColumnarData::rows() const
+{
+    return m_rows;
+}
+
+void AColumnarData::appendNull(QMetaType type)
+{
+    Column &col = m_columns[m_column];
+    switch (col.kind) {
+    case Kind::Null:
+        // Rows before the first value are marked when the column gets its type
+        if (!col.type.isValid()) {
+            col.type = type;
+        }
+        break;
+    case Kind::Variant:
+        col.variants.append(type.isValid() ? QVariant(type) : QVariant());
+        break;
+    case Kind::Bool:
+    case Kind::Int:
+    case Kind::Date:
+    case Kind::Time:
+        col.ints.push_back(0);
+        setNull(col.nulls, m_rows);
+        break;
+    case Kind::Double:
+        col.doubles.push_back(0);
+        setNull(col.nulls, m_rows);
+        break;
+    default:
+        col.offsets.push_back(col.arena.size());
+        setNull(col.nulls, m_rows);
+        break;
+    }
+    nextCell();
+}
+
+void AColumnarData::appendBool(bool value)
+{
+    if (Column *col = typedColumn(Kind::Bool, QMetaType::fromType<bool>())) {
+        col->ints.push_back(value);
+    } else {
+        m_columns[m_column].variants.append(value);
+    }
+    nextCell();
+}
+
+void AColumnarData::appendInt(qint64 value, QMetaType type)
+{
+    if (Column *col = typedColumn(Kind::Int, type)) {
+        col->ints.push_back(value);
+    } else {
+        QVariant variant(value);
+        if (type.id() != QMetaType::LongLong) {
+            variant.convert(type);
+        }
+        m_columns[m_column].variants.append(variant);
+    }
+    nextCell();
+}
+
+void AColumnarData::appendDouble(double value, QMetaType type)
+{
+    if (Column *col = typedColumn(Kind::Double, type)) {
+        col->doubles.push_back(value);
+    } else {
+        QVariant variant(value);
+        if (type.id() != QMetaType::Double) {
+            variant.convert(type);
+        }
+        m_columns[m_column].variants.append(variant);
+    }
+    nextCell();
+}
+
+void AColumnarData::appendText(QByteArrayView utf8)
+{
+    if (Column *col = typedColumn(Kind::String, QMetaType::fromType<QString>())) {
+        appendArena(*col, utf8);
+    } else {
+        m_columns[m_column].variants.append(QString::fromUtf8(utf8));
+    }
+    nextCell();
+}
+
+void AColumnarData::appendBytes(QByteArrayView data)
+{
+    if (Column *col = typedColumn(Kind::Bytes, QMetaType::fromType<QByteArray>())) {
+        appendArena(*col, data);
+    } else {
+        m_columns[m_column].variants.append(data.toByteArray());
+    }
+    nextCell();
+}
+
+void AColumnarData::appendDate(QDate value)
+{
+    if (Column *col = typedColumn(Kind::Date, QMetaType::fromType<QDate>())) {
+        col->ints.push_back(value.toJulianDay());
+    } else {
+        m_columns[m_column].variants.append(value);
+    }
+    nextCell();
+}
+
+void AColumnarData::appendTime(QTime value)
+{
+    if (Column *col = typedColumn(Kind::Time, QMetaType::fromType<QTime>())) {
+        col->ints.push_back(value.isValid() ? value.msecsSinceStartOfDay() : -1);
+    } else {
+        m_columns[m_column].variants.append(value);
+    }
+    nextCell();
+}
+
+void AColumnarData::append(const QVariant &value)
+{
+    if (value.isNull()) {
+        appendNull(value.metaType());
+        return;
+    }
+
+    const Kind kind = kindOf(value.metaType());
+    Column *col     = typedColumn(kind, value.metaType());
+    if (!col) {
+        m_columns[m_column].variants.append(value);
+        nextCell();
+        return;
+    }
+
+    switch (kind) {
+    case Kind::Bool:
+        col->ints.push_back(value.toBool());
+        break;
+    case Kind::Int:
+        col->ints.push_back(value.toLongLong());
+        break;
+    case Kind::Date:
+        col->ints.push_back(value.toDate().toJulianDay());
+        break;
+    case Kind::Time:
+    {
+        const QTime time = value.toTime();
+        col->ints.push_back(time.isValid() ? time.msecsSinceStartOfDay() : -1);
+        break;
+    }
+    case Kind::Double:
+        col->doubles.push_back(value.toDouble());
+        break;
+    case Kind::String:
+        appendArena(*col, value.toString().toUtf8());
+        break;
+    case Kind::Bytes:
+        appendArena(*col, value.toByteArray());
+        break;
+    case Kind::JsonObject:
+        appendArena(*col, QJsonDocument(value.toJsonObject()).toJson(QJsonDocument::Compact));
+        break;
+    case Kind::JsonArray:
+        appendArena(*col, QJsonDocument(value.toJsonArray()).toJson(QJsonDocument::Compact));
+        break;
+    case Kind::Uuid:
+        appendArena(*col, value.toUuid().toRfc4122());
+        break;
+    default:
+        break;
+    }
+    nextCell();
+}
+
+void AColumnarData::squeeze()
+{
+    for (Column &col : m_columns) {
+        col.nulls.shrink_to_fit();
+        col.ints.shrink_to_fit();
+        col.doubles.shrink_to_fit();
+        col.offsets.shrink_to_fit();
+        col.arena.squeeze();
+        col.variants.squeeze();
+    }
+}
+
+AColumnarData::Kind AColumnarData::kindOf(QMetaType type)
+{
+    switch (type.id()) {
+    case QMetaType::Bool:
+        return Kind::Bool;
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+        return Kind::Int;
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return Kind::Double;
+    case QMetaType::QString:
+        return Kind::String;
+    case QMetaType::QByteArray:
+        return Kind::Bytes;
+    case QMetaType::QJsonObject:
+        return Kind::JsonObject;
+    case QMetaType::QJsonArray:
+        return Kind::JsonArray;
+    case QMetaType::QDate:
+        return Kind::Date;
+    case QMetaType::QTime:
+        return Kind::Time;
+    case QMetaType::QUuid:
+        return Kind::Uuid;
+    default:
+        return Kind::Variant;
+    }
+}
+
+QByteArrayView AColumnarData::bytes(const Column &column, int row)
+{
+    return QByteArrayView(column.arena.constData() + column.offsets[row],
+                          column.offsets[row + 1] - column.offsets[row]);
+}
+
+/*!
+ * Returns the current column ready to store a value of \a kind, the first value sets
+ * the type of the column, or nullptr when the column keeps QVariant values.
+ */
+AColumnarData::Column *AColumnarData::typedColumn(Kind kind, QMetaType type)
+{
+    Column &col = m_columns[m_column];
+    if (col.kind == Kind::Null) {
+        const QMetaType nullType = col.type;
+        col.kind                 = kind;
+        col.type                 = type;
+
+        switch (kind) {
+        case Kind::Variant:
+            col.variants =
+                QVariantList(m_rows, nullType.isValid() ? QVariant(nullType) : QVariant());
+            return nullptr;
+        case Kind::Bool:
+        case Kind::Int:
+        case Kind::Date:
+        case Kind::Time:
+            col.ints.assign(m_rows, 0);
+            break;
+        case Kind::Double:
+            col.doubles.assign(m_rows, 0);
+            break;
+        default:
+            col.offsets.assign(m_rows + 1, 0);
+            break;
+        }
+
+        // Every row so far was NULL
+        col.nulls.assign(m_rows / 64, ~quint64(0));
+        if (m_rows % 64) {
+            col.nulls.push_back((quint64(1) << (m_rows % 64)) - 1);
+        }
+    } else if (col.kind != kind || col.type != type) {
+        if (col.kind != Kind::Variant) {
+            toVariant(m_column);
+        }
+        return nullptr;
+    }
+
+    return col.kind == Kind::Variant ? nullptr : &col;
+}
+
+void AColumnarData::toVariant(int column)
+{
+    QVariantList variants;
+    variants.reserve(m_rows + 1);
+    for (int row = 0; row < m_rows; ++row) {
+        variants.append(value(row, column));
+    }
+
+    Column &col  = m_columns[column];
+    col          = Column{.type = col.type, .kind = Kind::Variant};
+    col.variants = std::move(variants);
+}
+
+void AColumnarData::appendArena(Column &column, QByteArrayView data)
+{
+    column.arena.append(data);
+    column.offsets.push_back(column.arena.size());
+}
+
+void AColumnarData::nextCell()
+{
+    if (++m_column == int(m_columns.size())) {
+        m_column = 0;
+        ++m_rows;
+    }
+}
+
+QMetaType AColumnarData::columnType(int column) const
+{
+    const Column &col = m_columns.at(column);
+    if (col.kind == Kind::Null || col.kind == Kind::Variant) {
+        return {};
+    }
+    return col.type;
+}
+
+QVariant AColumnarData::value(int row, int column) const
+{
+    const Column &col = m_columns.at(column);
+    if (col.kind == Kind::Variant) {
+        return col.variants.at(row);
+    }
+
+    if (col.kind == Kind::Null || testNull(col.nulls, row)) {
+        return col.type.isValid() ? QVariant(col.type) : QVariant();
+    }
+
+    switch (col.kind) {
+    case Kind::Bool:
+        return bool(col.ints[row]);
+    case Kind::Int:
+    {
+        QVariant ret(col.ints[row]);
+        if (col.type.id() != QMetaType::LongLong) {
+            ret.convert(col.type);
+        }
+        return ret;
+    }
+    case Kind::Double:
+    {
+        QVariant ret(col.doubles[row]);
+        if (col.type.id() != QMetaType::Double) {
+            ret.convert(col.type);
+        }
+        return ret;
+    }
+    case Kind::String:
+        return QString::fromUtf8(bytes(col, row));
+    case Kind::Bytes:
+        return bytes(col, row).toByteArray();
+    case Kind::JsonObject:
+        return QJsonDocument::fromJson(bytes(col, row).toByteArray()).object();
+    case Kind::JsonArray:
+        return QJsonDocument::fromJson(bytes(col, row).toByteArray()).array();
+    case Kind::Date:
+        return QDate::fromJulianDay(col.ints[row]);
+    case Kind::Time:
+        return col.ints[row] < 0 ? QTime() : QTime::fromMSecsSinceStartOfDay(int(col.ints[row]));
+    case Kind::Uuid:
+        return QUuid::fromRfc4122(bytes(col, row));
+    default:
+        return {};
+    }
+}
+
+bool AColumnarData::isNull(int row, int column) const
+{
+    const Column &col = m_columns.at(column);
+    switch (col.kind) {
+    case Kind::Null:
+        return true;
+    case Kind::Variant:
+        return col.variants.at(row).isNull();
+    default:
+        return testNull(col.nulls, row);
+    }
+}
+
+bool AColumnarData::toBool(int row, int column) const
+{
+    const Column &col = m_columns.at(column);
+    switch (col.kind) {
+    case Kind::Bool:
+    case Kind::Int:
+        return col.ints[row] != 0;
+    case Kind::Double:
+        return col.doubles[row] != 0;
+    default:
+        return value(row, column).toBool();
+    }
+}
+
+qint64 AColumnarData::toLongLong(int row, int column) const
+{
+    const Column &col = m_columns.at(column);
+    switch (col.kind) {
+    case Kind::Bool:
+    case Kind::Int:
+        return col.ints[row];
+    case Kind::Double:
+        return qRound64(col.doubles[row]);
+    default:
+        return value(row, column).toLongLong();
+    }
+}
+
+quint64 AColumnarData::toULongLong(int row, int column) const
+{
+    const Column &col = m_columns.at(column);
+    switch (col.kind) {
+    case Kind::Bool:
+    case Kind::Int:
+        return quint64(col.ints[row]);
+    case Kind::Double:
+        return quint64(qRound64(col.doubles[row]));
+    default:
+        return value(row, column).toULongLong();
+    }
+}
+
+double AColumnarData::toDouble(int row, int column) const
+{
+    const Column &col = m_columns.at(column);
+    switch (col.kind) {
+    case Kind::Bool:
+    case Kind::Int:
+        return double(col.ints[row]);
+    case Kind::Double:
+        return col.doubles[row];
+    default:
+        return value(row, column).toDouble();
+    }
+}
+
+QString AColumnarData::toString(int row, int column) const
+{
+    const Column &col = m_columns.at(column);
+    if (isNull(row, column)) {
+        return {};
+    }
+
+    switch (col.kind) {
+    case Kind::String:
+    case Kind::JsonObject:
+    case Kind::JsonArray:
+        return QString::fromUtf8(bytes(col, row));
+    default:
+        return value(row, column).toString();
+    }
+}
+
+std::string AColumnarData::toStdString(int row, int column) const
+{
+    const Column &col = m_columns.at(column);
+    if (isNull(row, column)) {
+        return {};
+    }
+
+    switch (col.kind) {
+    case Kind::String:
+    case Kind::JsonObject:
+    case Kind::JsonArray:
+    {
+        const QByteArrayView view = bytes(col, row);
+        return std::string(view.data(), size_t(view.size()));
+    }
+    default:
+        return toString(row, column).toStdString();
+    }
+}
+
+QUuid AColumnarData::toUuid(int row, int column) const
+{
+    const Column &col = m_columns.at(column);
+    if (isNull(row, column)) {
+        return {};
+    }
+
+    switch (col.kind) {
+    case Kind::Uuid:
+        return QUuid::fromRfc4122(bytes(col, row));
+    case Kind::String:
+    case Kind::Bytes:
+        return QUuid::fromString(bytes(col, row));
+    default:
+        return value(row, column).toUuid();
+    }
+}
+
+QDate AColumnarData::toDate(int row, int column) const
+{
+    const Column &col = m_columns.at(column);
+    if (col.kind == Kind::Date && !testNull(col.nulls, row)) {
+        return QDate::fromJulianDay(col.ints[row]);
+    }
+    return value(row, column).toDate();
+}
+
+QJsonValue AColumnarData::toJsonValue(int row, int column) const
+{
+    const Column &col = m_columns.at(column);
+    if (isNull(row, column)) {
+        return {};
+    }
+
+    switch (col.kind) {
+    case Kind::String:
+    case Kind::JsonObject:
+    case Kind::JsonArray:
+        return parseJson(bytes(col, row));
+    default:
+        return QJsonValue::fromVariant(value(row, column));
+    }
+}
+
+QByteArray AColumnarData::toByteArray(int row, int column) const
+{
+    const Column &col = m_columns.at(column);
+    if (isNull(row, column)) {
+        return {};
+    }
+
+    switch (col.kind) {
+    case Kind::String:
+    case Kind::Bytes:
+    case Kind::JsonObject:
+    case Kind::JsonArray:
+        return bytes(col, row).toByteArray();
+    default:
+        return value(row, column).toByteArray();
+    }
+}
+
+bool AColumnarData::columnInto(int column, std::span<int> out, std::span<quint64> nulls) const
+{
+    const Column &col = m_columns.at(column);
+    if (col.kind == Kind::Int || col.kind == Kind::Bool) {
+        copyColumn(col.ints, col.nulls, out, nulls);
+    } else if (col.kind == Kind::Double) {
+        copyColumn(col.doubles, col.nulls, out, nulls);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool AColumnarData::columnInto(int column, std::span<qint64> out, std::span<quint64> nulls) const
+{
+    const Column &col = m_columns.at(column);
+    if (col.kind == Kind::Int || col.kind == Kind::Bool) {
+        copyColumn(col.ints, col.nulls, out, nulls);
+    } else if (col.kind == Kind::Double) {
+        copyColumn(col.doubles, col.nulls, out, nulls);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool AColumnarData::columnInto(int column, std::span<double> out, std::span<quint64> nulls) const
+{
+    const Column &col = m_columns.at(column);
+    if (col.kind == Kind::Int || col.kind == Kind::Bool) {
+        copyColumn(col.ints, col.nulls, out, nulls);
+    } else if (col.kind == Kind::Double) {
+        copyColumn(col.doubles, col.nulls, out, nulls);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool AColumnarData::columnInto(int column, std::span<QString> out, std::span<quint64> nulls) const
+{
+    const Column &col = m_columns.at(column);
+    if (col.kind != Kind::String) {
+        return false;
+    }
+
+    for (size_t row = 0; row < out.size(); ++row) {
+        const bool null = testNull(col.nulls, int(row));
+        detail::setNullBit(nulls, row, null);
+        out[row] = null ? QString{} : QString::fromUtf8(bytes(col, int(row)));
+    }
+    return true;
+}
+
+bool AColumnarData::writeJsonValue(QByteArray &out, int row, int column) const
+{
+    const Column &col = m_columns.at(column);
+    if (col.kind == Kind::Null || (col.kind != Kind::Variant && testNull(col.nulls, row))) {
+        out.append("null");
+        return true;
+    }
+
+    switch (col.kind) {
+    case Kind::Bool:
+        out.append(col.ints[row] ? "true" : "false");
+        break;
+    case Kind::Int:
+        out.append(QByteArray::number(col.ints[row]));
+        break;
+    case Kind::Double:
+        detail::appendJsonNumber(out, col.doubles[row]);
+        break;
+    case Kind::String:
+        detail::appendJsonString(out, bytes(col, row));
+        break;
+    case Kind::JsonObject:
+    case Kind::JsonArray:
+        out.append(bytes(col, row));
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+bool AColumnarData::writeCborValue(QCborStreamWriter &writer, int row, int column) const
+{
+    const Column &col = m_columns.at(column);
+    if (col.kind == Kind::Null || (col.kind != Kind::Variant && testNull(col.nulls, row))) {
+        writer.append(nullptr);
+        return true;
+    }
+
+    switch (col.kind) {
+    case Kind::Bool:
+        writer.append(bool(col.ints[row]));
+        break;
+    case Kind::Int:
+        writer.append(col.ints[row]);
+        break;
+    case Kind::Double:
+        writer.append(col.doubles[row]);
+        break;
+    case Kind::String:
+    {
+        const QByteArrayView utf8 = bytes(col, row);
+        writer.appendTextString(utf8.data(), utf8.size());
+        break;
+    }
+    case Kind::Bytes:
+    {
+        const QByteArrayView data = bytes(col, row);
+        writer.appendByteString(data.data(), data.size());
+        break;
+    }
+    default:
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,140 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2025 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <asql_export.h>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <QByteArrayView>
+#include <QDate>
+#include <QJsonValue>
+#include <QUuid>
+#include <QVariant>
+
+class QCborStreamWriter;
+
+namespace ASql {
+
+/*!
+ * \brief AColumnarData stores the cells of a result per column
+ *
+ * Integers and doubles are kept in typed arrays, text and binary values of a column share
+ * a single arena indexed by offsets and NULL values are tracked by a bitmap, which uses a
+ * fraction of the memory of a QVariant per cell.
+ *
+ * Cells are appended in row major order, as drivers fetch them. A column takes the type
+ * of its first non NULL value and falls back to QVariant storage when a later value has
+ * a different type, which SQLite allows.
+ */
+class ASQL_EXPORT AColumnarData
+{
+public:
+    /*!
+     * \brief reset clears all values and sets the number of \p columns of each row
+     */
+    void reset(int columns);
+
+    [[nodiscard]] int columns() const;
+    [[nodiscard]] int rows() const;
+
+    void appendNull(QMetaType type = {});
+    void appendBool(bool value);
+    void appendInt(qint64 value, QMetaType type = QMetaType::fromType<qint64>());
+    void appendDouble(double value, QMetaType type = QMetaType::fromType<double>());
+    void appendText(QByteArrayView utf8);
+    void appendBytes(QByteArrayView data);
+    void appendDate(QDate value);
+    void appendTime(QTime value);
+    void append(const QVariant &value);
+
+    /*!
+     * \brief squeeze releases the memory reserved for values that were not appended
+     */
+    void squeeze();
+
+    [[nodiscard]] QMetaType columnType(int column) const;
+    [[nodiscard]] QVariant value(int row, int column) const;
+
+    [[nodiscard]] bool isNull(int row, int column) const;
+    [[nodiscard]] bool toBool(int row, int column) const;
+    [[nodiscard]] qint64 toLongLong(int row, int column) const;
+    [[nodiscard]] quint64 toULongLong(int row, int column) const;
+    [[nodiscard]] double toDouble(int row, int column) const;
+    [[nodiscard]] QString toString(int row, int column) const;
+    [[nodiscard]] std::string toStdString(int row, int column) const;
+    [[nodiscard]] QUuid toUuid(int row, int column) const;
+    [[nodiscard]] QDate toDate(int row, int column) const;
+    [[nodiscard]] QJsonValue toJsonValue(int row, int column) const;
+    [[nodiscard]] QByteArray toByteArray(int row, int column) const;
+
+    /*!
+     * \brief columnInto copies a numeric or text column without going through QVariant
+     *
+     * \return false if the column is not stored with a suitable type, in which case
+     * \p out and \p nulls are left untouched.
+     */
+    bool columnInto(int column, std::span<int> out, std::span<quint64> nulls) const;
+    bool columnInto(int column, std::span<qint64> out, std::span<quint64> nulls) const;
+    bool columnInto(int column, std::span<double> out, std::span<quint64> nulls) const;
+    bool columnInto(int column, std::span<QString> out, std::span<quint64> nulls) const;
+
+    /*!
+     * \brief writeJsonValue appends the cell to \p out when it's stored with a JSON
+     * compatible type, returning false otherwise.
+     */
+    bool writeJsonValue(QByteArray &out, int row, int column) const;
+
+    /*!
+     * \brief writeCborValue encodes the cell with \p writer when it's stored with a CBOR
+     * compatible type, returning false otherwise.
+     */
+    bool writeCborValue(QCborStreamWriter &writer, int row, int column) const;
+
+private:
+    enum class Kind : quint8 {
+        Null,
+        Variant,
+        Bool,
+        Int,
+        Double,
+        String,
+        Bytes,
+        JsonObject,
+        JsonArray,
+        Date,
+        Time,
+        Uuid,
+    };
+
+    struct Column {
+        QMetaType type;
+        Kind kind = Kind::Null;
+        // One bit per row, only as long as the last NULL value
+        std::vector<quint64> nulls;
+        // Bool, Int, Date (julian day) and Time (msecs since start of day) values
+        std::vector<qint64> ints;
+        std::vector<double> doubles;
+        // rows + 1 offsets into arena for String, Bytes, Json and Uuid values
+        std::vector<qsizetype> offsets;
+        QByteArray arena;
+        QVariantList variants;
+    };
+
+    static Kind kindOf(QMetaType type);
+    [[nodiscard]] static inline QByteArrayView bytes(const Column &column, int row);
+
+    Column *typedColumn(Kind kind, QMetaType type);
+    void toVariant(int column);
+    static void appendArena(Column &column, QByteArrayView data);
+    void nextCell();
+
+    std::vector<Column> m_columns;
+    int m_rows   = 0;
+    int m_column = 0;
+};
+
+} // namespace ASql
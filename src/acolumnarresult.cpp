@@ -0,0 +1,207 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2025 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "acolumnarresult.h"
+
+#include <QCborValue>
+
+using namespace ASql;
+
+std::shared_ptr<AColumnarResult> AColumnarResult::fromResult(const AResult &result)
+{
+    auto ret               = std::make_shared<AColumnarResult>();
+    ret->m_query           = result.query();
+    ret->m_queryArgs       = result.queryArgs();
+    ret->m_fields          = result.columnNames();
+    ret->m_numRowsAffected = result.numRowsAffected();
+    ret->m_lastResultSet   = result.lastResultSet();
+
+    // Fetch the values once, as drivers might convert them on every call
+    const int columns = ret->m_fields.size();
+    ret->m_data.reset(columns);
+    for (auto row : result) {
+        for (int c = 0; c < columns; ++c) {
+            ret->m_data.append(row.value(c));
+        }
+    }
+    ret->m_data.squeeze();
+
+    return ret;
+}
+
+bool AColumnarResult::lastResultSet() const
+{
+    return m_lastResultSet;
+}
+
+bool AColumnarResult::hasError() const
+{
+    return false;
+}
+
+QString AColumnarResult::errorString() const
+{
+    return {};
+}
+
+QByteArray AColumnarResult::query() const
+{
+    return m_query;
+}
+
+QVariantList AColumnarResult::queryArgs() const
+{
+    return m_queryArgs;
+}
+
+int AColumnarResult::size() const
+{
+    return m_data.rows();
+}
+
+int AColumnarResult::fields() const
+{
+    return m_fields.size();
+}
+
+qint64 AColumnarResult::numRowsAffected() const
+{
+    return m_numRowsAffected;
+}
+
+QString AColumnarResult::fieldName(int column) const
+{
+    return m_fields.at(column);
+}
+
+QVariant AColumnarResult::value(int row, int column) const
+{
+    return m_data.value(row, column);
+}
+
+bool AColumnarResult::isNull(int row, int column) const
+{
+    return m_data.isNull(row, column);
+}
+
+bool AColumnarResult::toBool(int row, int column) const
+{
+    return m_data.toBool(row, column);
+}
+
+int AColumnarResult::toInt(int row, int column) const
+{
+    return int(m_data.toLongLong(row, column));
+}
+
+qint64 AColumnarResult::toLongLong(int row, int column) const
+{
+    return m_data.toLongLong(row, column);
+}
+
+quint64 AColumnarResult::toULongLong(int row, int column) const
+{
+    return m_data.toULongLong(row, column);
+}
+
+double AColumnarResult::toDouble(int row, int column) const
+{
+    return m_data.toDouble(row, column);
+}
+
+QString AColumnarResult::toString(int row, int column) const
+{
+    return m_data.toString(row, column);
+}
+
+std::string AColumnarResult::toStdString(int row, int column) const
+{
+    return m_data.toStdString(row, column);
+}
+
+QUuid AColumnarResult::toUuid(int row, int column) const
+{
+    return m_data.toUuid(row, column);
+}
+
+QDate AColumnarResult::toDate(int row, int column) const
+{
+    return m_data.toDate(row, column);
+}
+
+QTime AColumnarResult::toTime(int row, int column) const
+{
+    return value(row, column).toTime();
+}
+
+QDateTime AColumnarResult::toDateTime(int row, int column) const
+{
+    return value(row, column).toDateTime();
+}
+
+QJsonValue AColumnarResult::toJsonValue(int row, int column) const
+{
+    return m_data.toJsonValue(row, column);
+}
+
+QCborValue AColumnarResult::toCborValue(int row, int column) const
+{
+    // The cells hold the typed values of the original result, not encoded CBOR
+    return QCborValue::fromVariant(m_data.value(row, column));
+}
+
+QByteArray AColumnarResult::toByteArray(int row, int column) const
+{
+    return m_data.toByteArray(row, column);
+}
+
+void AColumnarResult::columnInto(int column, std::span<int> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
+}
+
+void AColumnarResult::columnInto(int column, std::span<qint64> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
+}
+
+void AColumnarResult::columnInto(int column, std::span<double> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
+}
+
+void AColumnarResult::columnInto(int column,
+                                 std::span<QString> out,
+                                 std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
+}
+
+QMetaType AColumnarResult::columnType(int column) const
+{
+    return m_data.columnType(column);
+}
+
+void AColumnarResult::writeJsonValue(QByteArray &out, int row, int column) const
+{
+    if (!m_data.writeJsonValue(out, row, column)) {
+        AResultPrivate::writeJsonValue(out, row, column);
+    }
+}
+
+void AColumnarResult::writeCborValue(QCborStreamWriter &writer, int row, int column) const
+{
+    if (!m_data.writeCborValue(writer, row, column)) {
+        AResultPrivate::writeCborValue(writer, row, column);
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2025 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <acolumnardata.h>
+#include <aresult.h>
+#include <asql_export.h>
+
+#include <QStringList>
+
+namespace ASql {
+
+/*!
+ * \brief AColumnarResult is a compact and immutable result storage
+ *
+ * Values are stored in an \sa AColumnarData, per column in typed arrays, strings and
+ * binary data share a single arena and NULL values are tracked by a bitmap, which uses
+ * a fraction of the memory of a QVariant per cell and keeps the values of a column close
+ * together.
+ *
+ * Columns that mix value types are kept as QVariant.
+ */
+class ASQL_EXPORT AColumnarResult final : public AResultPrivate
+{
+public:
+    /*!
+     * \brief fromResult copies all rows of \p result into a new columnar result
+     *
+     * \p result must not have an error.
+     */
+    static std::shared_ptr<AColumnarResult> fromResult(const AResult &result);
+
+    bool lastResultSet() const override;
+    bool hasError() const override;
+    QString errorString() const override;
+
+    QByteArray query() const override;
+    QVariantList queryArgs() const override;
+
+    int size() const override;
+    int fields() const override;
+    qint64 numRowsAffected() const override;
+
+    QString fieldName(int column) const override;
+    QVariant value(int row, int column) const override;
+
+    bool isNull(int row, int column) const override;
+    bool toBool(int row, int column) const override;
+    int toInt(int row, int column) const override;
+    qint64 toLongLong(int row, int column) const override;
+    quint64 toULongLong(int row, int column) const override;
+    double toDouble(int row, int column) const override;
+    QString toString(int row, int column) const override;
+    std::string toStdString(int row, int column) const override;
+    QUuid toUuid(int row, int column) const override;
+    QDate toDate(int row, int column) const override;
+    QTime toTime(int row, int column) const override;
+    QDateTime toDateTime(int row, int column) const override;
+    QJsonValue toJsonValue(int row, int column) const override;
+    QCborValue toCborValue(int row, int column) const override;
+    QByteArray toByteArray(int row, int column) const override;
+
+    void columnInto(int column, std::span<int> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<qint64> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<double> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<QString> out, std::span<quint64> nulls) const override;
+
+    QMetaType columnType(int column) const override;
+    void writeJsonValue(QByteArray &out, int row, int column) const override;
+    void writeCborValue(QCborStreamWriter &writer, int row, int column) const override;
+
+private:
+    QByteArray m_query;
+    QVariantList m_queryArgs;
+    QStringList m_fields;
+    AColumnarData m_data;
+    qint64 m_numRowsAffected = -1;
+    bool m_lastResultSet     = true;
+};
+
+} // namespace ASql
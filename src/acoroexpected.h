@@ -149,6 +149,7 @@ protected:
     friend class ACache;
     friend class ATransaction;
     friend class APool;
+    friend class AResult;
     std::shared_ptr<ACoroData<T>> m_data;
 
 private:
@@ -226,6 +226,24 @@ AExpectedResult
     return coro;
 }
 
+AExpectedResult
+    ADatabase::execBatch(QStringView query, const QList<QVariantList> &rows, QObject *receiver)
+{
+    Q_ASSERT(d);
+    AExpectedResult coro(receiver);
+    d->execBatch(d, query, rows, receiver, coro.ref());
+    return coro;
+}
+
+AExpectedResult
+    ADatabase::execBatch(QUtf8StringView query, const QList<QVariantList> &rows, QObject *receiver)
+{
+    Q_ASSERT(d);
+    AExpectedResult coro(receiver);
+    d->execBatch(d, query, rows, receiver, coro.ref());
+    return coro;
+}
+
 void ADatabase::setLastQuerySingleRowMode()
 {
     Q_ASSERT(d);
@@ -442,10 +442,48 @@ public:
     [[nodiscard]] AExpectedMultiResult execMulti(QUtf8StringView query,
                                                  QObject *receiver = nullptr);
 
+    /*!
+     * \brief execBatch executes a \param query once for each list of parameters in \p rows
+     *
+     * All rows are executed in a single transaction, the result has the sum of the
+     * affected rows. If a row fails the transaction is rolled back and the error names
+     * the index of that row. Rows returned by the query are discarded.
+     *
+     * Inside a transaction a savepoint is used instead, a failed row only undoes the
+     * batch and the transaction stays open.
+     *
+     * SQLite, MySQL and ODBC prepare the query once and run the whole batch on their
+     * worker thread. Postgres queues one exec() per row, it looks at the transaction
+     * status when execBatch() is called so queue the batch after the BEGIN has finished.
+     *
+     * \param query
+     * \param rows the parameters to be bound for each execution
+     * \param receiver that tracks the lifetime of this query
+     */
+    [[nodiscard]] AExpectedResult execBatch(QStringView query,
+                                            const QList<QVariantList> &rows,
+                                            QObject *receiver = nullptr);
+
+    /*!
+     * \brief execBatch executes a \param query once for each list of parameters in \p rows
+     *
+     * \note Since ASql might queue queries only use this method for strings that can outlive
+     * the query execution, such as string literals.
+     *
+     * \sa execBatch(QStringView, const QList<QVariantList> &, QObject *)
+     */
+    [[nodiscard]] AExpectedResult execBatch(QUtf8StringView query,
+                                            const QList<QVariantList> &rows,
+                                            QObject *receiver = nullptr);
+
     /**
      * @brief setSingleRowMode
      *
      * Enables single row mode only for the last sent or queued query.
+     *
+     * PostgreSQL delivers each row as a result of its own, SQLite and MySQL deliver
+     * batches of rows, with only a few batches buffered at a time, in both cases
+     * co_await for more results until AResult::lastResultSet() is true.
      */
     void setLastQuerySingleRowMode();
 
@@ -7,6 +7,8 @@
 
 #include "aresult.h"
 
+#include <optional>
+
 #include <QDate>
 #include <QJsonValue>
 #include <QUuid>
@@ -48,6 +50,178 @@ public:
     QByteArray toByteArray(int row, int column) const final { return {}; }
 };
 
+namespace {
+
+class AResultBatch final : public AResultPrivate
+{
+public:
+    AResultBatch(const QString &query)
+        : m_query{query.toUtf8()}
+    {
+    }
+
+    bool lastResultSet() const final { return true; }
+    bool hasError() const final { return m_error.has_value(); }
+    QString errorString() const final { return m_error.value_or(QString{}); }
+
+    QByteArray query() const final { return m_query; }
+    QVariantList queryArgs() const final { return {}; }
+
+    int size() const final { return 0; }
+    int fields() const final { return 0; }
+    qint64 numRowsAffected() const final { return m_numRowsAffected; }
+
+    QString fieldName(int column) const final { return {}; }
+    QVariant value(int row, int column) const final { return {}; }
+
+    bool isNull(int row, int column) const final { return true; }
+    bool toBool(int row, int column) const final { return false; }
+    int toInt(int row, int column) const final { return 0; }
+    qint64 toLongLong(int row, int column) const final { return 0; }
+    quint64 toULongLong(int row, int column) const final { return 0; }
+    double toDouble(int row, int column) const final { return 0; }
+    QString toString(int row, int column) const final { return {}; }
+    std::string toStdString(int row, int column) const final { return {}; }
+    QUuid toUuid(int row, int column) const final { return {}; }
+    QDate toDate(int row, int column) const final { return {}; }
+    QTime toTime(int row, int column) const final { return {}; }
+    QDateTime toDateTime(int row, int column) const final { return {}; }
+    QJsonValue toJsonValue(int row, int column) const final { return {}; }
+    QCborValue toCborValue(int row, int column) const final { return {}; }
+    QByteArray toByteArray(int row, int column) const final { return {}; }
+
+    QByteArray m_query;
+    std::optional<QString> m_error;
+    qint64 m_numRowsAffected = 0;
+};
+
+/*!
+ * Runs a batch on drivers without a native implementation, the rows are only queued
+ * once BEGIN succeeds and COMMIT or ROLLBACK once the last row is done. Inside a
+ * transaction a savepoint is used instead, ROLLBACK TO undoes only the batch.
+ *
+ * Statements are queued without a receiver so the transaction is always closed,
+ * the object keeps itself alive until the result is delivered.
+ */
+class ABatchExec final : public ACoroResult
+{
+public:
+    ABatchExec(const std::shared_ptr<ADriver> &driver,
+               const QString &query,
+               const QList<QVariantList> &rows,
+               bool savepoint,
+               ACoroDataRef cb)
+        : m_driver{driver}
+        , m_query{query}
+        , m_rows{rows}
+        , m_cb{std::move(cb)}
+        , m_result{std::make_shared<AResultBatch>(query)}
+        , m_savepoint{savepoint}
+    {
+    }
+
+    static void start(const std::shared_ptr<ADriver> &driver,
+                      const QString &query,
+                      const QList<QVariantList> &rows,
+                      bool savepoint,
+                      ACoroDataRef cb)
+    {
+        auto batch =
+            std::make_shared<ABatchExec>(driver, query, rows, savepoint, std::move(cb));
+        batch->m_self = batch;
+        if (savepoint) {
+            driver->exec(driver, u8"SAVEPOINT asql_batch", nullptr, batch->ref());
+        } else {
+            driver->begin(driver, nullptr, batch->ref());
+        }
+    }
+
+    void deliver(AResult &result) override
+    {
+        const qsizetype index = m_received++;
+        if (index == 0) {
+            if (result.hasError()) {
+                m_result->m_error = result.errorString();
+                finish();
+                return;
+            }
+
+            for (const QVariantList &params : std::as_const(m_rows)) {
+                m_driver->exec(m_driver, QStringView{m_query}, params, nullptr, ref());
+            }
+            if (m_rows.isEmpty()) {
+                commit();
+            }
+        } else if (index <= m_rows.size()) {
+            // Rows queued after a failed one still run, the ROLLBACK undoes them
+            if (!m_result->m_error && result.hasError()) {
+                m_result->m_error = u"Failed to execute row %1: %2"_s.arg(
+                    QString::number(index - 1), result.errorString());
+            } else if (!m_result->m_error) {
+                m_result->m_numRowsAffected += result.numRowsAffected();
+            }
+
+            if (index < m_rows.size()) {
+                return;
+            }
+
+            if (m_result->m_error) {
+                rollback();
+                finish();
+            } else {
+                commit();
+            }
+        } else {
+            if (result.hasError()) {
+                m_result->m_error = result.errorString();
+            }
+            finish();
+        }
+    }
+
+private:
+    ACoroDataRef ref() const { return ACoroDataRef{std::weak_ptr<ACoroResult>{m_self}}; }
+
+    void commit()
+    {
+        if (m_savepoint) {
+            m_driver->exec(m_driver, u8"RELEASE SAVEPOINT asql_batch", nullptr, ref());
+        } else {
+            m_driver->commit(m_driver, nullptr, ref());
+        }
+    }
+
+    void rollback()
+    {
+        if (m_savepoint) {
+            m_driver->exec(m_driver, u8"ROLLBACK TO SAVEPOINT asql_batch", nullptr, {});
+            m_driver->exec(m_driver, u8"RELEASE SAVEPOINT asql_batch", nullptr, {});
+        } else {
+            m_driver->rollback(m_driver, nullptr, {});
+        }
+    }
+
+    void finish()
+    {
+        // Released once this function returns
+        auto self = std::move(m_self);
+
+        AResult result{m_result};
+        m_cb.deliverResult(result);
+    }
+
+    std::shared_ptr<ADriver> m_driver;
+    std::shared_ptr<ABatchExec> m_self;
+    QString m_query;
+    QList<QVariantList> m_rows;
+    ACoroDataRef m_cb;
+    std::shared_ptr<AResultBatch> m_result;
+    qsizetype m_received = 0;
+    bool m_savepoint;
+};
+
+} // namespace
+
 ADriver::ADriver() = default;
 
 ADriver::ADriver(const QString &connectionInfo)
@@ -189,6 +363,35 @@ void ADriver::exec(const std::shared_ptr<ADriver> &db,
     }
 }
 
+void ADriver::execBatch(const std::shared_ptr<ADriver> &driver,
+                        QStringView query,
+                        const QList<QVariantList> &rows,
+                        QObject *receiver,
+                        ACoroDataRef cb)
+{
+    Q_UNUSED(receiver);
+    execBatchQueued(driver, query.toString(), rows, false, std::move(cb));
+}
+
+void ADriver::execBatch(const std::shared_ptr<ADriver> &driver,
+                        QUtf8StringView query,
+                        const QList<QVariantList> &rows,
+                        QObject *receiver,
+                        ACoroDataRef cb)
+{
+    Q_UNUSED(receiver);
+    execBatchQueued(driver, query.toString(), rows, false, std::move(cb));
+}
+
+void ADriver::execBatchQueued(const std::shared_ptr<ADriver> &driver,
+                              const QString &query,
+                              const QList<QVariantList> &rows,
+                              bool savepoint,
+                              ACoroDataRef cb)
+{
+    ABatchExec::start(driver, query, rows, savepoint, std::move(cb));
+}
+
 void ADriver::setLastQuerySingleRowMode()
 {
 }
@@ -67,6 +67,18 @@ public:
                       QObject *receiver,
                       ACoroDataRef cb);
 
+    virtual void execBatch(const std::shared_ptr<ADriver> &driver,
+                           QStringView query,
+                           const QList<QVariantList> &rows,
+                           QObject *receiver,
+                           ACoroDataRef cb);
+
+    virtual void execBatch(const std::shared_ptr<ADriver> &driver,
+                           QUtf8StringView query,
+                           const QList<QVariantList> &rows,
+                           QObject *receiver,
+                           ACoroDataRef cb);
+
     virtual void setLastQuerySingleRowMode();
 
     virtual bool enterPipelineMode(std::chrono::milliseconds timeout);
@@ -87,6 +99,20 @@ public:
     virtual void unsubscribeFromNotification(const std::shared_ptr<ADriver> &driver,
                                              const QString &name);
 
+protected:
+    /*!
+     * \brief execBatchQueued queues one exec() per row of \p rows, used by drivers without
+     * a native batch
+     *
+     * The rows run between BEGIN and COMMIT, or between SAVEPOINT and RELEASE when
+     * \p savepoint is true so a batch started inside a transaction does not end it.
+     */
+    static void execBatchQueued(const std::shared_ptr<ADriver> &driver,
+                                const QString &query,
+                                const QList<QVariantList> &rows,
+                                bool savepoint,
+                                ACoroDataRef cb);
+
 private:
     QString m_info;
 };
@@ -27,4 +27,14 @@ ADatabase ADriverFactory::createDatabase() const
     return {};
 }
 
+void ADriverFactory::setThreadPool(QThreadPool *pool)
+{
+    m_threadPool = pool;
+}
+
+QThreadPool *ADriverFactory::threadPool() const
+{
+    return m_threadPool;
+}
+
 ADriverFactory::~ADriverFactory() = default;
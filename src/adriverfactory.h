@@ -7,6 +7,8 @@
 #include <asql_export.h>
 #include <memory>
 
+class QThreadPool;
+
 namespace ASql {
 
 class ADriver;
@@ -20,6 +22,23 @@ public:
     virtual ADriver *createRawDriver() const;
     virtual std::shared_ptr<ADriver> createDriver() const;
     virtual ADatabase createDatabase() const;
+
+    /*!
+     * \brief setThreadPool makes drivers created afterwards run on \p pool
+     *
+     * Drivers with blocking APIs (SQLite, MySQL and ODBC) use a dedicated thread per
+     * connection by default. With a thread pool set each connection becomes a serial
+     * task queue on the pool, so the number of threads is bounded by the pool's
+     * maxThreadCount() instead of growing with the number of connections.
+     * Asynchronous drivers ignore this setting.
+     *
+     * The pool must outlive every driver created by this factory.
+     */
+    void setThreadPool(QThreadPool *pool);
+    QThreadPool *threadPool() const;
+
+private:
+    QThreadPool *m_threadPool = nullptr;
 };
 
 } // namespace ASql
@@ -8,7 +8,10 @@
 #include "acoroexpected.h"
 #include "aresult.h"
 
+#include <algorithm>
+#include <functional>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <QCborValue>
@@ -17,7 +20,6 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QLoggingCategory>
-#include <QMutexLocker>
 #include <QUrl>
 #include <QUrlQuery>
 #include <QUuid>
@@ -33,6 +35,22 @@ using namespace Qt::StringLiterals;
 // or my_bool* = char* (MariaDB).
 using MysqlBool = unsigned char;
 
+namespace {
+
+// The client library keeps per thread state, set up on the first task a thread runs
+// and released when the thread finishes, pool threads expire and get recreated
+struct AMysqlThreadInit {
+    AMysqlThreadInit() { mysql_thread_init(); }
+    ~AMysqlThreadInit() { mysql_thread_end(); }
+};
+
+void initMysqlThread()
+{
+    thread_local const AMysqlThreadInit init;
+}
+
+} // namespace
+
 // ---------------------------------------------------------------------------
 // AResultMysql
 // ---------------------------------------------------------------------------
@@ -64,7 +82,7 @@ QVariantList AResultMysql::queryArgs() const
 
 int AResultMysql::size() const
 {
-    return m_fields.empty() ? 0 : static_cast<int>(m_rows.size()) / m_fields.size();
+    return m_data.rows();
 }
 
 int AResultMysql::fields() const
@@ -77,11 +95,6 @@ qint64 AResultMysql::numRowsAffected() const
     return m_numRowsAffected;
 }
 
-int AResultMysql::indexOfField(QLatin1String name) const
-{
-    return m_fields.indexOf(name);
-}
-
 QString AResultMysql::fieldName(int column) const
 {
     if (column >= 0 && column < m_fields.size()) {
@@ -92,56 +105,55 @@ QString AResultMysql::fieldName(int column) const
 
 QVariant AResultMysql::value(int row, int column) const
 {
-    const int idx = row * m_fields.size() + column;
-    if (idx >= 0 && idx < m_rows.size()) {
-        return m_rows.at(idx);
+    if (row >= 0 && row < m_data.rows() && column >= 0 && column < m_data.columns()) {
+        return m_data.value(row, column);
     }
     return {};
 }
 
 bool AResultMysql::isNull(int row, int column) const
 {
-    return value(row, column).isNull();
+    return m_data.isNull(row, column);
 }
 
 bool AResultMysql::toBool(int row, int column) const
 {
-    return value(row, column).toBool();
+    return m_data.toBool(row, column);
 }
 
 int AResultMysql::toInt(int row, int column) const
 {
-    return value(row, column).toInt();
+    return int(m_data.toLongLong(row, column));
 }
 
 qint64 AResultMysql::toLongLong(int row, int column) const
 {
-    return value(row, column).toLongLong();
+    return m_data.toLongLong(row, column);
 }
 
 quint64 AResultMysql::toULongLong(int row, int column) const
 {
-    return value(row, column).toULongLong();
+    return m_data.toULongLong(row, column);
 }
 
 double AResultMysql::toDouble(int row, int column) const
 {
-    return value(row, column).toDouble();
+    return m_data.toDouble(row, column);
 }
 
 QString AResultMysql::toString(int row, int column) const
 {
-    return value(row, column).toString();
+    return m_data.toString(row, column);
 }
 
 std::string AResultMysql::toStdString(int row, int column) const
 {
-    return value(row, column).toString().toStdString();
+    return m_data.toStdString(row, column);
 }
 
 QUuid AResultMysql::toUuid(int row, int column) const
 {
-    return QUuid::fromString(value(row, column).toString());
+    return m_data.toUuid(row, column);
 }
 
 QDate AResultMysql::toDate(int row, int column) const
@@ -207,7 +219,35 @@ QCborValue AResultMysql::toCborValue(int row, int column) const
 
 QByteArray AResultMysql::toByteArray(int row, int column) const
 {
-    return value(row, column).toByteArray();
+    return m_data.toByteArray(row, column);
+}
+
+void AResultMysql::columnInto(int column, std::span<int> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
+}
+
+void AResultMysql::columnInto(int column, std::span<qint64> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
+}
+
+void AResultMysql::columnInto(int column, std::span<double> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
+}
+
+void AResultMysql::columnInto(int column, std::span<QString> out, std::span<quint64> nulls) const
+{
+    if (!m_data.columnInto(column, out, nulls)) {
+        AResultPrivate::columnInto(column, out, nulls);
+    }
 }
 
 // ---------------------------------------------------------------------------
@@ -217,17 +257,17 @@ QByteArray AResultMysql::toByteArray(int row, int column) const
 /*!
  * \brief Reads all columns of the current row from a text-protocol result set.
  *
- * Each column value is appended to \a rows as a QString (or a null QVariant
+ * Each column value is appended to \a rows as UTF-8 text (or NULL
  * for SQL NULL).  \a numFields must equal mysql_num_fields(res).
  */
 static void
-    mysqlFillRow(MYSQL_ROW row, unsigned int numFields, unsigned long *lengths, QVariantList &rows)
+    mysqlFillRow(MYSQL_ROW row, unsigned int numFields, unsigned long *lengths, AColumnarData &rows)
 {
     for (unsigned int i = 0; i < numFields; ++i) {
         if (row[i] == nullptr) {
-            rows.append(QVariant{});
+            rows.appendNull();
         } else {
-            rows.append(QString::fromUtf8(row[i], static_cast<int>(lengths[i])));
+            rows.appendText(QByteArrayView(row[i], static_cast<qsizetype>(lengths[i])));
         }
     }
 }
@@ -370,13 +410,16 @@ static std::optional<QString> mysqlBindParams(MYSQL_STMT *stmt,
  * typical scalar values).  If a value is truncated, mysql_stmt_fetch_column()
  * is used to retrieve the full data.  Binary/BLOB columns are returned as
  * QByteArray; all other columns are returned as QString (UTF-8 decoded).
+ * \a rowFetched is called after each row and stops the fetch by returning false.
  *
  * \return empty optional on success; an error message string on failure.
  */
-static std::optional<QString> mysqlFetchStmtRows(MYSQL_STMT *stmt,
-                                                 unsigned int numFields,
-                                                 MYSQL_FIELD *fields,
-                                                 QVariantList &rows)
+static std::optional<QString>
+    mysqlFetchStmtRows(MYSQL_STMT *stmt,
+                       unsigned int numFields,
+                       MYSQL_FIELD *fields,
+                       AColumnarData &rows,
+                       const std::function<bool(AColumnarData &rows)> &rowFetched)
 {
     // Initial buffer per column — covers nearly all scalar values without a
     // second fetch, but is small enough to avoid excessive allocation for
@@ -420,7 +463,7 @@ static std::optional<QString> mysqlFetchStmtRows(MYSQL_STMT *stmt,
     while ((fetchRet = mysql_stmt_fetch(stmt)) == 0 || fetchRet == MYSQL_DATA_TRUNCATED) {
         for (unsigned int i = 0; i < numFields; ++i) {
             if (isNull[i]) {
-                rows.append(QVariant{});
+                rows.appendNull();
                 continue;
             }
 
@@ -435,23 +478,28 @@ static std::optional<QString> mysqlFetchStmtRows(MYSQL_STMT *stmt,
                 colBind.buffer        = bigBuf.data();
                 colBind.buffer_length = lengths[i];
                 if (mysql_stmt_fetch_column(stmt, &colBind, i, 0) != 0) {
-                    rows.append(QVariant{});
+                    rows.appendNull();
                     continue;
                 }
                 if (isBinary) {
-                    rows.append(bigBuf);
+                    rows.appendBytes(bigBuf);
                 } else {
-                    rows.append(QString::fromUtf8(bigBuf.constData(), actualLen));
+                    rows.appendText(bigBuf);
                 }
             } else {
                 // Data fits in the initial buffer.
+                const QByteArrayView data(bufs[i].constData(), actualLen);
                 if (isBinary) {
-                    rows.append(bufs[i].left(actualLen));
+                    rows.appendBytes(data);
                 } else {
-                    rows.append(QString::fromUtf8(bufs[i].constData(), actualLen));
+                    rows.appendText(data);
                 }
             }
         }
+
+        if (!rowFetched(rows)) {
+            return u"Interrupt requested"_s;
+        }
     }
 
     if (fetchRet != MYSQL_NO_DATA) {
@@ -482,11 +530,55 @@ AMysqlThread::~AMysqlThread()
 
 void AMysqlThread::enqueueAndSignal(MysqlQueryPromise &promise)
 {
-    {
-        QMutexLocker _(&m_promisesMutex);
-        m_promisesReady.enqueue(std::move(promise));
+    // Only the first result since the owner thread last drained the queue wakes it up
+    if (m_promisesReady.push(std::move(promise))) {
+        Q_EMIT queryReady();
     }
-    Q_EMIT queryReady();
+}
+
+/*!
+ * \brief Hands a batch of rows to the owner thread when the query is in single row mode.
+ *
+ * Every m_batchRows rows become a result of their own, at most m_batchSlots of them
+ * are waiting for the owner thread, the remaining rows stay in the promise result.
+ *
+ * \return false when the worker was interrupted while waiting for a free slot.
+ */
+bool AMysqlThread::rowFetched(MysqlQueryPromise &promise, AColumnarData &rows)
+{
+    const int columns = promise.result->m_fields.size();
+    if (!columns || rows.rows() < m_batchRows ||
+        m_singleRowQuery.load(std::memory_order_relaxed) != promise.id) {
+        return true;
+    }
+
+    while (!m_batchSlots.tryAcquire(1, 100)) {
+        if (interrupted()) {
+            return false;
+        }
+    }
+
+    auto next         = std::make_shared<AResultMysql>();
+    next->m_query     = promise.result->m_query;
+    next->m_queryArgs = promise.result->m_queryArgs;
+    next->m_fields    = promise.result->m_fields;
+
+    promise.result->m_data          = std::move(rows);
+    promise.result->m_lastResultSet = false;
+    rows.reset(columns);
+
+    MysqlQueryPromise batch = promise;
+    batch.streamed          = true;
+    enqueueAndSignal(batch);
+
+    promise.result = std::move(next);
+    return true;
+}
+
+bool AMysqlThread::interrupted() const
+{
+    return m_closing.load(std::memory_order_relaxed) ||
+           QThread::currentThread()->isInterruptionRequested();
 }
 
 void AMysqlThread::open()
@@ -498,6 +590,11 @@ void AMysqlThread::open()
     }
 
     QUrl url(m_connInfo);
+    const QUrlQuery query{url.query()};
+    if (query.hasQueryItem(u"BATCH_ROWS"_s)) {
+        m_batchRows = std::max(1, query.queryItemValue(u"BATCH_ROWS"_s).toInt());
+    }
+
     const QByteArray host     = url.host().toUtf8();
     const QByteArray user     = url.userName().toUtf8();
     const QByteArray password = url.password().toUtf8();
@@ -588,11 +685,17 @@ void AMysqlThread::query(MysqlQueryPromise promise)
             promise.result->m_fields.append(QString::fromUtf8(fields[i].name));
         }
 
-        auto fetchErr = mysqlFetchStmtRows(stmt, numFields, fields, promise.result->m_rows);
+        AColumnarData rows;
+        rows.reset(static_cast<int>(numFields));
+        auto fetchErr =
+            mysqlFetchStmtRows(stmt, numFields, fields, rows, [&](AColumnarData &fetched) {
+            return rowFetched(promise, fetched);
+        });
         if (fetchErr.has_value()) {
             promise.result->m_error = fetchErr;
             return;
         }
+        promise.result->m_data = std::move(rows);
     }
 
     promise.result->m_numRowsAffected = static_cast<qint64>(mysql_stmt_affected_rows(stmt));
@@ -660,16 +763,98 @@ void AMysqlThread::queryPrepared(MysqlQueryPromise promise)
             promise.result->m_fields.append(QString::fromUtf8(fields[i].name));
         }
 
-        auto fetchErr = mysqlFetchStmtRows(stmt, numFields, fields, promise.result->m_rows);
+        AColumnarData rows;
+        rows.reset(static_cast<int>(numFields));
+        auto fetchErr =
+            mysqlFetchStmtRows(stmt, numFields, fields, rows, [&](AColumnarData &fetched) {
+            return rowFetched(promise, fetched);
+        });
         if (fetchErr.has_value()) {
             promise.result->m_error = fetchErr;
             return;
         }
+        promise.result->m_data = std::move(rows);
     }
 
     promise.result->m_numRowsAffected = static_cast<qint64>(mysql_stmt_affected_rows(stmt));
 }
 
+/*!
+ * \brief Executes the statement once for each row of parameters in a single transaction.
+ *
+ * The libmysqlclient API has no array binding, so the statement is prepared
+ * once and only the parameters are sent for each row.  When a transaction is
+ * already open a savepoint is used instead so that the batch stays atomic.
+ */
+void AMysqlThread::queryBatch(MysqlQueryPromise promise)
+{
+    auto _ = qScopeGuard([&] { enqueueAndSignal(promise); });
+
+    MYSQL_STMT *stmt = prepare(promise);
+    if (!stmt) {
+        return;
+    }
+    auto stmtGuard = qScopeGuard([&] { mysql_stmt_close(stmt); });
+
+    const bool inTransaction = m_mysql->server_status & SERVER_STATUS_IN_TRANS;
+    const char *begin        = inTransaction ? "SAVEPOINT asql_batch" : "START TRANSACTION";
+    if (mysql_query(m_mysql, begin) != 0) {
+        promise.result->m_error =
+            u"Failed to begin batch: "_s + QString::fromUtf8(mysql_error(m_mysql));
+        return;
+    }
+
+    std::vector<MYSQL_BIND> binds;
+    std::vector<long long> intVals;
+    std::vector<double> doubleVals;
+    std::unique_ptr<MysqlBool[]> nullFlags;
+    std::vector<QByteArray> strVals;
+    std::vector<unsigned long> strLengths;
+
+    qint64 changes                  = 0;
+    const QList<QVariantList> &rows = promise.batch;
+    for (qsizetype i = 0; i < rows.size(); ++i) {
+        if (interrupted()) {
+            promise.result->m_error = u"Interrupt requested"_s;
+            break;
+        }
+
+        auto bindErr = mysqlBindParams(
+            stmt, rows.at(i), binds, intVals, doubleVals, nullFlags, strVals, strLengths);
+        if (bindErr.has_value()) {
+            promise.result->m_error =
+                u"Failed to bind row %1: %2"_s.arg(QString::number(i), *bindErr);
+            break;
+        }
+
+        if (mysql_stmt_execute(stmt) != 0) {
+            promise.result->m_error = u"Failed to execute row %1: %2"_s.arg(
+                QString::number(i), QString::fromUtf8(mysql_stmt_error(stmt)));
+            break;
+        }
+
+        const auto affected = mysql_stmt_affected_rows(stmt);
+        if (affected != static_cast<decltype(affected)>(-1)) {
+            changes += static_cast<qint64>(affected);
+        }
+        // Rows returned by the statement are discarded
+        mysql_stmt_free_result(stmt);
+    }
+
+    const char *end = inTransaction ? "RELEASE SAVEPOINT asql_batch" : "COMMIT";
+    if (!promise.result->m_error && mysql_query(m_mysql, end) != 0) {
+        promise.result->m_error =
+            u"Failed to commit batch: "_s + QString::fromUtf8(mysql_error(m_mysql));
+    }
+
+    if (promise.result->m_error) {
+        mysql_query(m_mysql, inTransaction ? "ROLLBACK TO SAVEPOINT asql_batch" : "ROLLBACK");
+        return;
+    }
+
+    promise.result->m_numRowsAffected = changes;
+}
+
 void AMysqlThread::queryExec(MysqlQueryPromise promise)
 {
     auto _ = qScopeGuard([&] { enqueueAndSignal(promise); });
@@ -680,7 +865,8 @@ void AMysqlThread::queryExec(MysqlQueryPromise promise)
         return;
     }
 
-    MYSQL_RES *res = mysql_store_result(m_mysql);
+    // Rows are read from the server as they are fetched instead of buffered up front
+    MYSQL_RES *res = mysql_use_result(m_mysql);
     if (res) {
         auto resGuard = qScopeGuard([&] { mysql_free_result(res); });
 
@@ -691,11 +877,23 @@ void AMysqlThread::queryExec(MysqlQueryPromise promise)
             promise.result->m_fields.append(QString::fromUtf8(fields[i].name));
         }
 
+        AColumnarData rows;
+        rows.reset(static_cast<int>(numFields));
         MYSQL_ROW row;
         while ((row = mysql_fetch_row(res)) != nullptr) {
             unsigned long *lengths = mysql_fetch_lengths(res);
-            mysqlFillRow(row, numFields, lengths, promise.result->m_rows);
+            mysqlFillRow(row, numFields, lengths, rows);
+            if (!rowFetched(promise, rows)) {
+                promise.result->m_error = u"Interrupt requested"_s;
+                return;
+            }
         }
+
+        if (mysql_errno(m_mysql) != 0) {
+            promise.result->m_error = QString::fromUtf8(mysql_error(m_mysql));
+            return;
+        }
+        promise.result->m_data = std::move(rows);
     } else if (mysql_field_count(m_mysql) != 0) {
         // Query should have produced a result set but didn't → error
         promise.result->m_error = QString::fromUtf8(mysql_error(m_mysql));
@@ -709,17 +907,21 @@ void AMysqlThread::queryExec(MysqlQueryPromise promise)
 // ADriverMysql
 // ---------------------------------------------------------------------------
 
-ADriverMysql::ADriverMysql(const QString &connInfo)
+ADriverMysql::ADriverMysql(const QString &connInfo, QThreadPool *pool)
     : ADriver(connInfo)
     , m_worker(connInfo)
 {
-    m_thread.setObjectName(connInfo);
-    m_worker.moveToThread(&m_thread);
+    if (pool) {
+        m_strand = std::make_unique<AStrand>(pool);
+    } else {
+        m_thread.setObjectName(connInfo);
+        m_worker.moveToThread(&m_thread);
+    }
 
     connect(&m_worker, &AMysqlThread::queryReady, this, [this] {
-        QMutexLocker _(&m_worker.m_promisesMutex);
-        while (!m_worker.m_promisesReady.isEmpty()) {
-            MysqlQueryPromise promise = m_worker.m_promisesReady.dequeue();
+        m_worker.m_promisesReady.wakeupReceived();
+        while (auto ready = m_worker.m_promisesReady.pop()) {
+            MysqlQueryPromise promise = std::move(*ready);
             if (!promise.receiver.has_value() || !promise.receiver->isNull()) {
                 if (promise.cb) {
                     AResult result{promise.result};
@@ -727,24 +929,49 @@ ADriverMysql::ADriverMysql(const QString &connInfo)
                 }
             }
 
+            if (promise.streamed) {
+                m_worker.m_batchSlots.release();
+            }
+
             if (promise.result->m_lastResultSet && --m_queueSize == 0) {
                 selfDriver.reset();
             }
         }
     }, Qt::QueuedConnection);
 
-    m_thread.start();
+    if (!m_strand) {
+        m_thread.start();
+    }
 }
 
 ADriverMysql::~ADriverMysql()
 {
     Q_ASSERT(m_thread.thread() == QThread::currentThread());
 
+    // Queued tasks are dropped as with the thread, but the running one must finish
+    m_worker.m_closing = true;
+    m_strand.reset();
+
     m_thread.requestInterruption();
     m_thread.quit();
     m_thread.wait();
 }
 
+template <typename Method, typename... Args>
+void ADriverMysql::dispatch(Method method, Args... args)
+{
+    auto task = [worker = &m_worker, method, ... args = std::move(args)]() mutable {
+        initMysqlThread();
+        (worker->*method)(std::move(args)...);
+    };
+
+    if (m_strand) {
+        m_strand->post(std::move(task));
+    } else {
+        QMetaObject::invokeMethod(&m_worker, std::move(task), Qt::QueuedConnection);
+    }
+}
+
 QString ADriverMysql::driverName() const
 {
     return u"mysql"_s;
@@ -793,11 +1020,7 @@ void ADriverMysql::open(const std::shared_ptr<ADriver> &driver, QObject *receive
         }
     }, Qt::SingleShotConnection);
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(&m_worker, &AMysqlThread::open, Qt::QueuedConnection);
-#else
-    QMetaObject::invokeMethod(&m_worker, "open", Qt::QueuedConnection);
-#endif
+    dispatch(&AMysqlThread::open);
 }
 
 bool ADriverMysql::isOpen() const
@@ -855,20 +1078,13 @@ void ADriverMysql::exec(const std::shared_ptr<ADriver> &db,
         .cb     = std::move(cb),
         .result = std::make_shared<AResultMysql>(),
     };
+    data.id = ++m_lastQueryId;
     if (receiver) {
         data.receiver = receiver;
     }
     data.result->m_query.setRawData(query.data(), query.size());
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &AMysqlThread::queryExec, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(&m_worker,
-                              "queryExec",
-                              Qt::QueuedConnection,
-                              Q_ARG(ASql::MysqlQueryPromise, std::move(data)));
-#endif
+    dispatch(&AMysqlThread::queryExec, std::move(data));
 }
 
 void ADriverMysql::exec(const std::shared_ptr<ADriver> &db,
@@ -883,20 +1099,13 @@ void ADriverMysql::exec(const std::shared_ptr<ADriver> &db,
         .cb     = std::move(cb),
         .result = std::make_shared<AResultMysql>(),
     };
+    data.id = ++m_lastQueryId;
     if (receiver) {
         data.receiver = receiver;
     }
     data.result->m_query = query.toUtf8();
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &AMysqlThread::queryExec, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(&m_worker,
-                              "queryExec",
-                              Qt::QueuedConnection,
-                              Q_ARG(ASql::MysqlQueryPromise, std::move(data)));
-#endif
+    dispatch(&AMysqlThread::queryExec, std::move(data));
 }
 
 void ADriverMysql::exec(const std::shared_ptr<ADriver> &db,
@@ -912,19 +1121,14 @@ void ADriverMysql::exec(const std::shared_ptr<ADriver> &db,
         .cb     = std::move(cb),
         .result = std::make_shared<AResultMysql>(),
     };
+    data.id = ++m_lastQueryId;
     if (receiver) {
         data.receiver = receiver;
     }
     data.result->m_query.setRawData(query.data(), query.size());
     data.result->m_queryArgs = params;
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &AMysqlThread::query, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(
-        &m_worker, "query", Qt::QueuedConnection, Q_ARG(ASql::MysqlQueryPromise, std::move(data)));
-#endif
+    dispatch(&AMysqlThread::query, std::move(data));
 }
 
 void ADriverMysql::exec(const std::shared_ptr<ADriver> &db,
@@ -940,19 +1144,14 @@ void ADriverMysql::exec(const std::shared_ptr<ADriver> &db,
         .cb     = std::move(cb),
         .result = std::make_shared<AResultMysql>(),
     };
+    data.id = ++m_lastQueryId;
     if (receiver) {
         data.receiver = receiver;
     }
     data.result->m_query     = query.toUtf8();
     data.result->m_queryArgs = params;
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &AMysqlThread::query, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(
-        &m_worker, "query", Qt::QueuedConnection, Q_ARG(ASql::MysqlQueryPromise, std::move(data)));
-#endif
+    dispatch(&AMysqlThread::query, std::move(data));
 }
 
 void ADriverMysql::exec(const std::shared_ptr<ADriver> &db,
@@ -969,26 +1168,66 @@ void ADriverMysql::exec(const std::shared_ptr<ADriver> &db,
         .cb            = std::move(cb),
         .result        = std::make_shared<AResultMysql>(),
     };
+    data.id = ++m_lastQueryId;
     if (receiver) {
         data.receiver = receiver;
     }
     data.result->m_query     = query.query();
     data.result->m_queryArgs = params;
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
-    QMetaObject::invokeMethod(
-        &m_worker, &AMysqlThread::queryPrepared, Qt::QueuedConnection, std::move(data));
-#else
-    QMetaObject::invokeMethod(&m_worker,
-                              "queryPrepared",
-                              Qt::QueuedConnection,
-                              Q_ARG(ASql::MysqlQueryPromise, std::move(data)));
-#endif
+    dispatch(&AMysqlThread::queryPrepared, std::move(data));
+}
+
+void ADriverMysql::execBatch(const std::shared_ptr<ADriver> &db,
+                             QStringView query,
+                             const QList<QVariantList> &rows,
+                             QObject *receiver,
+                             ACoroDataRef cb)
+{
+    ++m_queueSize;
+    selfDriver = db;
+
+    MysqlQueryPromise data{
+        .batch  = rows,
+        .cb     = std::move(cb),
+        .result = std::make_shared<AResultMysql>(),
+    };
+    data.id = ++m_lastQueryId;
+    if (receiver) {
+        data.receiver = receiver;
+    }
+    data.result->m_query = query.toUtf8();
+
+    dispatch(&AMysqlThread::queryBatch, std::move(data));
+}
+
+void ADriverMysql::execBatch(const std::shared_ptr<ADriver> &db,
+                             QUtf8StringView query,
+                             const QList<QVariantList> &rows,
+                             QObject *receiver,
+                             ACoroDataRef cb)
+{
+    ++m_queueSize;
+    selfDriver = db;
+
+    MysqlQueryPromise data{
+        .batch  = rows,
+        .cb     = std::move(cb),
+        .result = std::make_shared<AResultMysql>(),
+    };
+    data.id = ++m_lastQueryId;
+    if (receiver) {
+        data.receiver = receiver;
+    }
+    data.result->m_query.setRawData(query.data(), query.size());
+
+    dispatch(&AMysqlThread::queryBatch, std::move(data));
 }
 
 void ADriverMysql::setLastQuerySingleRowMode()
 {
-    // Not supported for MySQL driver
+    // Checked by the worker each time it has a batch of rows ready
+    m_worker.m_singleRowQuery = m_lastQueryId;
 }
 
 bool ADriverMysql::enterPipelineMode(std::chrono::milliseconds timeout)
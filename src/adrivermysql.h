@@ -4,9 +4,12 @@
  */
 #pragma once
 
+#include "acolumnardata.h"
 #include "acoroexpected.h"
 #include "apreparedquery.h"
 #include "aresult.h"
+#include "aspscqueue.h"
+#include "astrand.h"
 
 #include <adriver.h>
 #if __has_include(<mariadb/mysql.h>)
@@ -14,12 +17,12 @@
 #else
 #    include <mysql/mysql.h>
 #endif
+#include <atomic>
 #include <optional>
 
 #include <QHash>
-#include <QMutex>
 #include <QPointer>
-#include <QQueue>
+#include <QSemaphore>
 #include <QThread>
 
 namespace ASql {
@@ -41,7 +44,6 @@ public:
     int fields() const override;
     qint64 numRowsAffected() const override;
 
-    int indexOfField(QLatin1String name) const override;
     QString fieldName(int column) const override;
     QVariant value(int row, int column) const override;
 
@@ -61,10 +63,15 @@ public:
     QCborValue toCborValue(int row, int column) const override;
     QByteArray toByteArray(int row, int column) const override;
 
+    void columnInto(int column, std::span<int> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<qint64> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<double> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<QString> out, std::span<quint64> nulls) const override;
+
     QByteArray m_query;
     QVariantList m_queryArgs;
     QStringList m_fields;
-    QVariantList m_rows; // flat: row*fields+col
+    AColumnarData m_data;
     qint64 m_numRowsAffected = -1;
     std::optional<QString> m_error;
     bool m_lastResultSet = true;
@@ -77,9 +84,12 @@ struct OpenPromise {
 
 struct MysqlQueryPromise {
     std::optional<APreparedQuery> preparedQuery;
+    QList<QVariantList> batch;
     ACoroDataRef cb;
     std::shared_ptr<AResultMysql> result;
     std::optional<QPointer<QObject>> receiver;
+    quint64 id    = 0;
+    bool streamed = false;
 };
 
 class AMysqlThread final : public QThread
@@ -89,14 +99,18 @@ public:
     AMysqlThread(const QString &connInfo);
     ~AMysqlThread();
 
-    QMutex m_promisesMutex;
-    QQueue<ASql::MysqlQueryPromise> m_promisesReady;
+    ASpscQueue<ASql::MysqlQueryPromise> m_promisesReady;
+    // Streamed batches not yet consumed by the owner thread
+    QSemaphore m_batchSlots{4};
+    std::atomic<quint64> m_singleRowQuery = 0;
+    std::atomic<bool> m_closing           = false;
 
 public Q_SLOTS:
     void open();
     void query(ASql::MysqlQueryPromise promise);
     void queryPrepared(ASql::MysqlQueryPromise promise);
     void queryExec(ASql::MysqlQueryPromise promise);
+    void queryBatch(ASql::MysqlQueryPromise promise);
 
 Q_SIGNALS:
     void openned(bool isOpen, QString error);
@@ -105,17 +119,20 @@ Q_SIGNALS:
 private:
     MYSQL_STMT *prepare(MysqlQueryPromise &promise);
     void enqueueAndSignal(MysqlQueryPromise &promise);
+    bool rowFetched(MysqlQueryPromise &promise, AColumnarData &rows);
+    bool interrupted() const;
 
     QHash<int, MYSQL_STMT *> m_preparedQueries;
     QString m_connInfo;
-    MYSQL *m_mysql = nullptr;
+    MYSQL *m_mysql  = nullptr;
+    int m_batchRows = 256;
 };
 
 class ADriverMysql final : public ADriver
 {
     Q_OBJECT
 public:
-    ADriverMysql(const QString &connInfo);
+    ADriverMysql(const QString &connInfo, QThreadPool *pool = nullptr);
     virtual ~ADriverMysql() override;
 
     QString driverName() const override;
@@ -162,6 +179,18 @@ public:
               QObject *receiver,
               ACoroDataRef cb) override;
 
+    void execBatch(const std::shared_ptr<ADriver> &db,
+                   QStringView query,
+                   const QList<QVariantList> &rows,
+                   QObject *receiver,
+                   ACoroDataRef cb) override;
+
+    void execBatch(const std::shared_ptr<ADriver> &db,
+                   QUtf8StringView query,
+                   const QList<QVariantList> &rows,
+                   QObject *receiver,
+                   ACoroDataRef cb) override;
+
     void setLastQuerySingleRowMode() override;
 
     bool enterPipelineMode(std::chrono::milliseconds timeout) override;
@@ -183,12 +212,18 @@ public:
                                      const QString &name) override;
 
 private:
+    // Runs a worker method on the connection thread or on the strand
+    template <typename Method, typename... Args>
+    void dispatch(Method method, Args... args);
+
     std::optional<QPointer<QObject>> m_stateChangedReceiver;
     std::function<void(ADatabase::State, const QString &)> m_stateChangedCb;
     std::shared_ptr<ADriver> selfDriver;
     AMysqlThread m_worker;
     QThread m_thread;
+    std::unique_ptr<AStrand> m_strand;
     ADatabase::State m_state = ADatabase::State::Disconnected;
+    quint64 m_lastQueryId    = 0;
     int m_queueSize          = 0;
 };
 
@@ -6,10 +6,13 @@
 #include "adriverpg.h"
 
 #include "acoroexpected.h"
+#include "apgparsers.h"
 #include "aresult.h"
 
+#include <charconv>
 #include <libpq-fe.h>
 
+#include <QCborStreamWriter>
 #include <QDate>
 #include <QJsonArray>
 #include <QJsonDocument>
@@ -117,6 +120,32 @@ inline QMetaType qDecodePSQLType(int t)
     return QMetaType(type);
 }
 
+// Converts a whole column straight from the libpq text values
+template <typename T>
+void pgColumnInto(PGresult *result, int column, std::span<T> out, std::span<quint64> nulls)
+{
+    Q_ASSERT_X(column < PQnfields(result), "columnInto", "column out of range");
+    for (size_t row = 0; row < out.size(); ++row) {
+        const bool null = PQgetisnull(result, int(row), column);
+        detail::setNullBit(nulls, row, null);
+        if (null) {
+            out[row] = T{};
+            continue;
+        }
+
+        const char *val = PQgetvalue(result, int(row), column);
+        const int len   = PQgetlength(result, int(row), column);
+        if constexpr (std::is_same_v<T, QString>) {
+            out[row] = QString::fromUtf8(val, len);
+        } else {
+            // from_chars also parses the Infinity and NaN values of double columns
+            T number{};
+            std::from_chars(val, val + len, number);
+            out[row] = number;
+        }
+    }
+}
+
 QString connectionStatus(ConnStatusType type)
 {
     switch (type) {
@@ -568,6 +597,37 @@ void ADriverPg::exec(const std::shared_ptr<ADriver> &db,
     }
 }
 
+void ADriverPg::execBatch(const std::shared_ptr<ADriver> &db,
+                          QStringView query,
+                          const QList<QVariantList> &rows,
+                          QObject *receiver,
+                          ACoroDataRef cb)
+{
+    Q_UNUSED(receiver);
+    execBatchQueued(db, query.toString(), rows, inTransaction(), std::move(cb));
+}
+
+void ADriverPg::execBatch(const std::shared_ptr<ADriver> &db,
+                          QUtf8StringView query,
+                          const QList<QVariantList> &rows,
+                          QObject *receiver,
+                          ACoroDataRef cb)
+{
+    Q_UNUSED(receiver);
+    execBatchQueued(db, query.toString(), rows, inTransaction(), std::move(cb));
+}
+
+bool ADriverPg::inTransaction() const
+{
+    // Also in a failed transaction, the SAVEPOINT reports the error instead of
+    // a ROLLBACK ending the caller's transaction
+    if (!m_conn) {
+        return false;
+    }
+    const PGTransactionStatusType status = PQtransactionStatus(m_conn->conn());
+    return status == PQTRANS_INTRANS || status == PQTRANS_INERROR;
+}
+
 void ADriverPg::setLastQuerySingleRowMode()
 {
     if (m_queuedQueries.size() == 1) {
@@ -970,6 +1030,12 @@ bool ADriverPg::isConnected() const
 AResultPg::AResultPg(PGresult *result)
     : m_result{result}
 {
+    const int columns = PQnfields(m_result);
+    m_columnTypes.reserve(columns);
+    for (int i = 0; i < columns; ++i) {
+        const Oid oid = PQftype(m_result, i);
+        m_columnTypes.push_back({oid, qDecodePSQLType(int(oid))});
+    }
 }
 
 AResultPg::~AResultPg()
@@ -1022,16 +1088,6 @@ qint64 AResultPg::numRowsAffected() const
     return QString::fromLatin1(PQcmdTuples(m_result)).toLongLong();
 }
 
-int AResultPg::indexOfField(QLatin1String name) const
-{
-    for (int i = 0; i < fields(); ++i) {
-        if (qstrcmp(name.data(), PQfname(m_result, i)) == 0) {
-            return i;
-        }
-    }
-    return -1;
-}
-
 QString AResultPg::fieldName(int column) const
 {
     return QString::fromUtf8(PQfname(m_result, column));
@@ -1039,13 +1095,12 @@ QString AResultPg::fieldName(int column) const
 
 QVariant AResultPg::value(int row, int column) const
 {
-    if (column >= PQnfields(m_result)) {
+    if (column < 0 || column >= int(m_columnTypes.size())) {
         qWarning(ASQL_PG, "column %d out of range", column);
         return {};
     }
 
-    int ptype      = PQftype(m_result, column);
-    QMetaType type = qDecodePSQLType(ptype);
+    const QMetaType type = m_columnTypes[column].type;
     if (PQgetisnull(m_result, row, column)) {
         return QVariant(type, nullptr);
     }
@@ -1092,45 +1147,11 @@ QVariant AResultPg::value(int row, int column) const
         return QString::fromLatin1(val).toDouble();
     }
     case QMetaType::QDate:
-        if (val[0] == '\0') {
-            return QDate();
-        } else {
-#ifndef QT_NO_DATESTRING
-            return QDate::fromString(QString::fromLatin1(val), Qt::ISODate);
-#else
-            return QString::fromLatin1(val);
-#endif
-        }
+        return detail::pgDate(QByteArrayView(val, PQgetlength(m_result, row, column)));
     case QMetaType::QTime:
-    {
-        const QString str = QString::fromLatin1(val);
-#ifndef QT_NO_DATESTRING
-        if (str.isEmpty()) {
-            return QTime();
-        } else {
-            return QTime::fromString(str, Qt::ISODate);
-        }
-#else
-        return QVariant(str);
-#endif
-    }
+        return detail::pgTime(QByteArrayView(val, PQgetlength(m_result, row, column)));
     case QMetaType::QDateTime:
-    {
-        QString dtval = QString::fromLatin1(val);
-#ifndef QT_NO_DATESTRING
-        if (dtval.length() < 10) {
-            return QDateTime();
-        } else {
-            QChar sign = dtval[dtval.size() - 3];
-            if (sign == u'-' || sign == u'+') {
-                dtval += u":00";
-            }
-            return QDateTime::fromString(dtval, Qt::ISODate);
-        }
-#else
-        return dtval;
-#endif
-    }
+        return detail::pgDateTime(QByteArrayView(val, PQgetlength(m_result, row, column)));
     case QMetaType::QByteArray:
     {
         size_t len;
@@ -1150,7 +1171,7 @@ QVariant AResultPg::value(int row, int column) const
         break;
     }
     case QMetaType::QUuid:
-        return QUuid::fromString(val);
+        return detail::pgUuid(QByteArrayView(val, PQgetlength(m_result, row, column)));
     default:
     case QMetaType::UnknownType:
         qWarning(ASQL_PG, "unknown data type");
@@ -1235,58 +1256,28 @@ QUuid AResultPg::toUuid(int row, int column) const
     }
 
     const char *val = PQgetvalue(m_result, row, column);
-    return QUuid::fromString(val);
+    return detail::pgUuid(QByteArrayView(val, PQgetlength(m_result, row, column)));
 }
 
 QDate AResultPg::toDate(int row, int column) const
 {
     Q_ASSERT_X(column < PQnfields(m_result), "toDate", "column out of range");
     const char *val = PQgetvalue(m_result, row, column);
-    if (val[0] == '\0') {
-        return {};
-    } else {
-#ifndef QT_NO_DATESTRING
-        return QDate::fromString(QString::fromLatin1(val), Qt::ISODate);
-#else
-        return {};
-#endif
-    }
+    return detail::pgDate(QByteArrayView(val, PQgetlength(m_result, row, column)));
 }
 
 QTime AResultPg::toTime(int row, int column) const
 {
     Q_ASSERT_X(column < PQnfields(m_result), "toTime", "column out of range");
-    const char *val   = PQgetvalue(m_result, row, column);
-    const QString str = QString::fromLatin1(val);
-#ifndef QT_NO_DATESTRING
-    if (str.isEmpty()) {
-        return {};
-    } else {
-        return QTime::fromString(str, Qt::ISODate);
-    }
-#else
-    return {};
-#endif
+    const char *val = PQgetvalue(m_result, row, column);
+    return detail::pgTime(QByteArrayView(val, PQgetlength(m_result, row, column)));
 }
 
 QDateTime AResultPg::toDateTime(int row, int column) const
 {
     Q_ASSERT_X(column < PQnfields(m_result), "toDateTime", "column out of range");
     const char *val = PQgetvalue(m_result, row, column);
-    QString dtval   = QString::fromLatin1(val);
-#ifndef QT_NO_DATESTRING
-    if (dtval.length() < 10) {
-        return {};
-    } else {
-        QChar sign = dtval[dtval.size() - 3];
-        if (sign == u'-' || sign == u'+') {
-            dtval += u":00";
-        }
-        return QDateTime::fromString(dtval, Qt::ISODate);
-    }
-#else
-    return {};
-#endif
+    return detail::pgDateTime(QByteArrayView(val, PQgetlength(m_result, row, column)));
 }
 
 QJsonValue AResultPg::toJsonValue(int row, int column) const
@@ -1331,4 +1322,124 @@ QByteArray AResultPg::toByteArray(int row, int column) const
     return ba;
 }
 
+void AResultPg::columnInto(int column, std::span<int> out, std::span<quint64> nulls) const
+{
+    pgColumnInto(m_result, column, out, nulls);
+}
+
+void AResultPg::columnInto(int column, std::span<qint64> out, std::span<quint64> nulls) const
+{
+    pgColumnInto(m_result, column, out, nulls);
+}
+
+void AResultPg::columnInto(int column, std::span<double> out, std::span<quint64> nulls) const
+{
+    pgColumnInto(m_result, column, out, nulls);
+}
+
+void AResultPg::columnInto(int column, std::span<QString> out, std::span<quint64> nulls) const
+{
+    pgColumnInto(m_result, column, out, nulls);
+}
+
+QMetaType AResultPg::columnType(int column) const
+{
+    Q_ASSERT_X(column < int(m_columnTypes.size()), "columnType", "column out of range");
+    return m_columnTypes[column].type;
+}
+
+void AResultPg::writeJsonValue(QByteArray &out, int row, int column) const
+{
+    Q_ASSERT_X(column < int(m_columnTypes.size()), "writeJsonValue", "column out of range");
+    if (PQgetisnull(m_result, row, column) == 1) {
+        out.append("null");
+        return;
+    }
+
+    const char *val = PQgetvalue(m_result, row, column);
+    const int len   = PQgetlength(m_result, row, column);
+    const auto &ct  = m_columnTypes[column];
+    switch (ct.oid) {
+    case QBOOLOID:
+        out.append(val[0] == 't' ? "true" : "false");
+        break;
+    case QINT8OID:
+    case QINT2OID:
+    case QINT4OID:
+    case QOIDOID:
+    case QXIDOID:
+    case QCIDOID:
+        out.append(val, len);
+        break;
+    case QNUMERICOID:
+    case QFLOAT4OID:
+    case QFLOAT8OID:
+        // NaN and Infinity are not valid JSON numbers
+        if (val[0] == 'N' || val[0] == 'I' || (val[0] == '-' && val[1] == 'I')) {
+            out.append("null");
+        } else {
+            out.append(val, len);
+        }
+        break;
+    case QJSONOID:
+    case QJSONBOID:
+        out.append(val, len);
+        break;
+    case QUUIDOID:
+        detail::appendJsonString(out, QByteArrayView(val, len));
+        break;
+    default:
+        if (ct.type.id() == QMetaType::QString) {
+            detail::appendJsonString(out, QByteArrayView(val, len));
+        } else {
+            AResultPrivate::writeJsonValue(out, row, column);
+        }
+    }
+}
+
+void AResultPg::writeCborValue(QCborStreamWriter &writer, int row, int column) const
+{
+    Q_ASSERT_X(column < int(m_columnTypes.size()), "writeCborValue", "column out of range");
+    if (PQgetisnull(m_result, row, column) == 1) {
+        writer.append(nullptr);
+        return;
+    }
+
+    const char *val = PQgetvalue(m_result, row, column);
+    const int len   = PQgetlength(m_result, row, column);
+    const auto &ct  = m_columnTypes[column];
+    switch (ct.oid) {
+    case QBOOLOID:
+        writer.append(val[0] == 't');
+        break;
+    case QINT8OID:
+    case QINT2OID:
+    case QINT4OID:
+    case QOIDOID:
+    case QXIDOID:
+    case QCIDOID:
+    {
+        qint64 number = 0;
+        std::from_chars(val, val + len, number);
+        writer.append(number);
+        break;
+    }
+    case QNUMERICOID:
+    case QFLOAT4OID:
+    case QFLOAT8OID:
+    {
+        double number = 0;
+        std::from_chars(val, val + len, number);
+        writer.append(number);
+        break;
+    }
+    default:
+        if (ct.type.id() == QMetaType::QString) {
+            writer.appendTextString(val, len);
+        } else {
+            AResultPrivate::writeCborValue(writer, row, column);
+        }
+    }
+}
+
 #include "moc_adriverpg.cpp"
@@ -15,6 +15,7 @@
 #include <QHash>
 #include <QPointer>
 #include <queue>
+#include <vector>
 
 class QTimer;
 
@@ -39,7 +40,6 @@ public:
     int fields() const override;
     qint64 numRowsAffected() const override;
 
-    int indexOfField(QLatin1String name) const override;
     QString fieldName(int column) const override;
     QVariant value(int row, int column) const override;
 
@@ -59,11 +59,27 @@ public:
     QCborValue toCborValue(int row, int column) const final;
     QByteArray toByteArray(int row, int column) const override;
 
+    void columnInto(int column, std::span<int> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<qint64> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<double> out, std::span<quint64> nulls) const override;
+    void columnInto(int column, std::span<QString> out, std::span<quint64> nulls) const override;
+
+    QMetaType columnType(int column) const override;
+    void writeJsonValue(QByteArray &out, int row, int column) const override;
+    void writeCborValue(QCborStreamWriter &writer, int row, int column) const override;
+
     inline void processResult();
 
+    // Column types decoded once when the result is created
+    struct ColumnType {
+        Oid oid;
+        QMetaType type;
+    };
+
     QByteArray m_query;
     QVariantList m_queryArgs;
     QString m_errorString;
+    std::vector<ColumnType> m_columnTypes;
     PGresult *m_result   = nullptr;
     bool m_error         = false;
     bool m_lastResultSet = true;
@@ -181,6 +197,17 @@ public:
               QObject *receiver,
               ACoroDataRef cb) override;
 
+    void execBatch(const std::shared_ptr<ADriver> &db,
+                   QStringView query,
+                   const QList<QVariantList> &rows,
+                   QObject *receiver,
+                   ACoroDataRef cb) override;
+    void execBatch(const std::shared_ptr<ADriver> &db,
+                   QUtf8StringView query,
+                   const QList<QVariantList> &rows,
+                   QObject *receiver,
+                   ACoroDataRef cb) override;
+
     void setLastQuerySingleRowMode() override;
 
     bool enterPipelineMode(std::chrono::milliseconds timeout) override;
@@ -212,6 +239,7 @@ private:
     inline void setSingleRowMode();
     inline void cmdFlush();
     inline bool isConnected() const;
+    inline bool inTransaction() const;
     ACoroTerminator listenCoro(std::shared_ptr<ADriver> db, QString name);
     ACoroTerminator unlistenCoro(std::shared_ptr<ADriver> db, QString name);
 
@@ -50,17 +50,17 @@ ADatabase AMysql::database(const QString &connectionInfo)
 
 ADriver *AMysql::createRawDriver() const
 {
-    auto ret = new ADriverMysql(d->connection);
+    auto ret = new ADriverMysql(d->connection, threadPool());
     return ret;
 }
 
 std::shared_ptr<ADriver> AMysql::createDriver() const
 {
-    auto ret = std::make_shared<ADriverMysql>(d->connection);
+    auto ret = std::make_shared<ADriverMysql>(d->connection, threadPool());
     return ret;
 }
 
 ADatabase AMysql::createDatabase() const
 {
-    return ADatabase(std::make_shared<ADriverMysql>(d->connection));
+    return ADatabase(std::make_shared<ADriverMysql>(d->connection, threadPool()));
 }
@@ -0,0 +1,218 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2025 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <optional>
+
+#include <QByteArrayView>
+#include <QDateTime>
+#include <QTimeZone>
+#include <QUuid>
+
+/*!
+ * Parsers for the text output of PostgreSQL temporal and UUID types
+ *
+ * The fast parsers only accept the fixed ISO format PostgreSQL uses by default,
+ * "YYYY-MM-DD HH:MM:SS[.ffffff][+HH[:MM[:SS]]]", and return std::nullopt for anything
+ * else, like BC dates or infinity, which is then handled by the slower Qt::ISODate path.
+ */
+namespace ASql::detail {
+
+inline int pgDigits(QByteArrayView text, qsizetype pos, qsizetype count)
+{
+    int ret = 0;
+    for (qsizetype i = pos; i < pos + count; ++i) {
+        const int digit = text[i] - '0';
+        if (digit < 0 || digit > 9) {
+            return -1;
+        }
+        ret = ret * 10 + digit;
+    }
+    return ret;
+}
+
+inline std::optional<QDate> pgFastDate(QByteArrayView text)
+{
+    if (text.size() < 10 || text[4] != '-' || text[7] != '-') {
+        return {};
+    }
+
+    const int year  = pgDigits(text, 0, 4);
+    const int month = pgDigits(text, 5, 2);
+    const int day   = pgDigits(text, 8, 2);
+    if (year < 0 || month < 0 || day < 0) {
+        return {};
+    }
+    return QDate(year, month, day);
+}
+
+// Parses "HH:MM:SS[.ffffff]" at the start of text, setting the number of parsed characters
+inline std::optional<QTime> pgFastTimePrefix(QByteArrayView text, qsizetype &parsed)
+{
+    if (text.size() < 8 || text[2] != ':' || text[5] != ':') {
+        return {};
+    }
+
+    const int hour   = pgDigits(text, 0, 2);
+    const int minute = pgDigits(text, 3, 2);
+    const int second = pgDigits(text, 6, 2);
+    // 24:00:00 is valid in PostgreSQL but not for QTime
+    if (hour < 0 || hour > 23 || minute < 0 || second < 0) {
+        return {};
+    }
+
+    int msec = 0;
+    parsed   = 8;
+    if (text.size() > 9 && text[8] == '.') {
+        parsed = 9;
+        int scale = 100;
+        while (parsed < text.size() && text[parsed] >= '0' && text[parsed] <= '9') {
+            const int digit = text[parsed] - '0';
+            if (scale) {
+                msec += digit * scale;
+                scale /= 10;
+            } else if (parsed == 12 && digit >= 5 && msec < 999) {
+                // Round the microseconds to the closest millisecond
+                ++msec;
+            }
+            ++parsed;
+        }
+    }
+    return QTime(hour, minute, second, msec);
+}
+
+inline std::optional<QTime> pgFastTime(QByteArrayView text)
+{
+    qsizetype parsed = 0;
+    auto ret         = pgFastTimePrefix(text, parsed);
+    if (parsed != text.size()) {
+        return {};
+    }
+    return ret;
+}
+
+inline std::optional<QDateTime> pgFastDateTime(QByteArrayView text)
+{
+    if (text.size() < 19 || text[10] != ' ') {
+        return {};
+    }
+
+    const auto date = pgFastDate(text.first(10));
+    if (!date) {
+        return {};
+    }
+
+    qsizetype parsed = 0;
+    const auto time  = pgFastTimePrefix(text.sliced(11), parsed);
+    if (!time) {
+        return {};
+    }
+
+    const QByteArrayView zone = text.sliced(11 + parsed);
+    if (zone.isEmpty()) {
+        return QDateTime(*date, *time);
+    }
+
+    // +HH[:MM[:SS]]
+    const bool hasSign = zone[0] == '+' || zone[0] == '-';
+    if (!hasSign || (zone.size() != 3 && zone.size() != 6 && zone.size() != 9)) {
+        return {};
+    }
+
+    int offset = 0;
+    for (qsizetype pos = 1, unit = 3600; pos < zone.size(); pos += 3, unit /= 60) {
+        const int value = pgDigits(zone, pos, 2);
+        if (value < 0 || (pos + 2 < zone.size() && zone[pos + 2] != ':')) {
+            return {};
+        }
+        offset += value * int(unit);
+    }
+    return QDateTime(*date, *time,
+                     QTimeZone::fromSecondsAheadOfUtc(zone[0] == '-' ? -offset : offset));
+}
+
+inline std::optional<QUuid> pgFastUuid(QByteArrayView text)
+{
+    if (text.size() != 36 || text[8] != '-' || text[13] != '-' || text[18] != '-' ||
+        text[23] != '-') {
+        return {};
+    }
+
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        c |= 0x20;
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        return -1;
+    };
+
+    char bytes[16];
+    qsizetype pos = 0;
+    for (char &byte : bytes) {
+        if (text[pos] == '-') {
+            ++pos;
+        }
+        const int high = nibble(text[pos]);
+        const int low  = nibble(text[pos + 1]);
+        if (high < 0 || low < 0) {
+            return {};
+        }
+        byte = char((high << 4) | low);
+        pos += 2;
+    }
+    return QUuid::fromRfc4122(QByteArrayView(bytes, sizeof(bytes)));
+}
+
+inline QDate pgDate(QByteArrayView text)
+{
+    if (text.isEmpty()) {
+        return {};
+    }
+    if (const auto date = pgFastDate(text); date && text.size() == 10) {
+        return *date;
+    }
+    return QDate::fromString(QString::fromLatin1(text), Qt::ISODate);
+}
+
+inline QTime pgTime(QByteArrayView text)
+{
+    if (text.isEmpty()) {
+        return {};
+    }
+    if (const auto time = pgFastTime(text)) {
+        return *time;
+    }
+    return QTime::fromString(QString::fromLatin1(text), Qt::ISODate);
+}
+
+inline QDateTime pgDateTime(QByteArrayView text)
+{
+    if (text.size() < 10) {
+        return {};
+    }
+    if (auto dateTime = pgFastDateTime(text)) {
+        return *dateTime;
+    }
+
+    QString dtval    = QString::fromLatin1(text);
+    const QChar sign = dtval[dtval.size() - 3];
+    if (sign == u'-' || sign == u'+') {
+        dtval += u":00";
+    }
+    return QDateTime::fromString(dtval, Qt::ISODate);
+}
+
+inline QUuid pgUuid(QByteArrayView text)
+{
+    if (const auto uuid = pgFastUuid(text)) {
+        return *uuid;
+    }
+    return QUuid::fromString(QLatin1StringView(text));
+}
+
+} // namespace ASql::detail
@@ -520,6 +520,71 @@ AExpectedResult APool::exec(const APreparedQuery &query,
 
     return coro;
 }
+
+AExpectedResult APool::execBatch(QStringView query,
+                                 const QList<QVariantList> &rows,
+                                 QObject *receiver,
+                                 QStringView poolName)
+{
+    AExpectedResult coro(receiver);
+    auto ref = coro.ref();
+
+    [](ACoroDataRef ref,
+       auto query,
+       QList<QVariantList> rows,
+       QObject *receiver,
+       QStringView poolName) -> ACoroTerminator {
+        auto db = co_await database(receiver, poolName);
+        if (db) {
+            auto result = co_await db->execBatch(query, rows, receiver);
+            if (result) {
+                ref.deliverResult(*result);
+            } else {
+                AResult error{std::make_shared<AResultError>(result.error())};
+                ref.deliverResult(error);
+            }
+            co_return;
+        }
+
+        AResult error{std::make_shared<AResultError>(db.error())};
+        ref.deliverResult(error);
+    }(std::move(ref), query, rows, receiver, poolName);
+
+    return coro;
+}
+
+AExpectedResult APool::execBatch(QUtf8StringView query,
+                                 const QList<QVariantList> &rows,
+                                 QObject *receiver,
+                                 QStringView poolName)
+{
+    AExpectedResult coro(receiver);
+    auto ref = coro.ref();
+
+    [](ACoroDataRef ref,
+       auto query,
+       QList<QVariantList> rows,
+       QObject *receiver,
+       QStringView poolName) -> ACoroTerminator {
+        auto db = co_await database(receiver, poolName);
+        if (db) {
+            auto result = co_await db->execBatch(query, rows, receiver);
+            if (result) {
+                ref.deliverResult(*result);
+            } else {
+                AResult error{std::make_shared<AResultError>(result.error())};
+                ref.deliverResult(error);
+            }
+            co_return;
+        }
+
+        AResult error{std::make_shared<AResultError>(db.error())};
+        ref.deliverResult(error);
+    }(std::move(ref), query, rows, receiver, poolName);
+
+    return coro;
+}
+
 AExpectedTransaction APool::begin(QObject *receiver, QStringView poolName)
 {
     AExpectedTransaction coro(receiver);
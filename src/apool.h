@@ -172,6 +172,16 @@ public:
                                               QObject *receiver    = nullptr,
                                               QStringView poolName = defaultPool);
 
+    [[nodiscard]] static AExpectedResult execBatch(QStringView query,
+                                                   const QList<QVariantList> &rows,
+                                                   QObject *receiver    = nullptr,
+                                                   QStringView poolName = defaultPool);
+
+    [[nodiscard]] static AExpectedResult execBatch(QUtf8StringView query,
+                                                   const QList<QVariantList> &rows,
+                                                   QObject *receiver    = nullptr,
+                                                   QStringView poolName = defaultPool);
+
     [[nodiscard]] static AExpectedTransaction begin(QObject *receiver    = nullptr,
                                                     QStringView poolName = defaultPool);
 
@@ -5,15 +5,299 @@
 
 #include "aresult.h"
 
+#include "acoroexpected.h"
+
+#include <algorithm>
+
 #include <QCborArray>
 #include <QCborMap>
+#include <QCborStreamWriter>
 #include <QDateTime>
 #include <QJsonArray>
+#include <QJsonDocument>
 #include <QJsonObject>
+#include <QLocale>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QVarLengthArray>
 
 using namespace ASql;
 using namespace Qt::StringLiterals;
 
+namespace {
+
+template <typename T, typename Func>
+void fillColumn(const AResultPrivate *d,
+                int column,
+                std::span<T> out,
+                std::span<quint64> nulls,
+                Func toValue)
+{
+    for (size_t row = 0; row < out.size(); ++row) {
+        const bool null = d->isNull(int(row), column);
+        detail::setNullBit(nulls, row, null);
+        out[row] = null ? T{} : toValue(int(row));
+    }
+}
+
+// Writes the JSON layouts in pieces, the rows (or the columns of Layout::ObjectArray)
+// are split in ranges of units that can be written independently and then joined
+class JsonWriter
+{
+public:
+    JsonWriter(const AResultPrivate *d, AResult::Layout layout)
+        : m_d(d)
+        , m_layout(layout)
+        , m_rows(d->size())
+        , m_columns(d->fields())
+    {
+        m_keys.reserve(m_columns);
+        for (int i = 0; i < m_columns; ++i) {
+            QByteArray key;
+            detail::appendJsonString(key, d->fieldName(i));
+            m_keys.emplace_back(std::move(key));
+        }
+    }
+
+    int units() const { return m_layout == AResult::Layout::ObjectArray ? m_columns : m_rows; }
+
+    std::vector<std::pair<int, int>> split(int maxChunks) const
+    {
+        // Small chunks cost more to schedule than to write
+        const int minUnits = m_layout == AResult::Layout::ObjectArray ? 1 : 1024;
+        const int total    = units();
+        const int chunks   = std::clamp(total / minUnits, total ? 1 : 0, std::max(maxChunks, 1));
+
+        std::vector<std::pair<int, int>> ranges;
+        ranges.reserve(chunks);
+        for (int i = 0; i < chunks; ++i) {
+            ranges.emplace_back(int(qint64(total) * i / chunks),
+                                int(qint64(total) * (i + 1) / chunks));
+        }
+        return ranges;
+    }
+
+    void writeHeader(QByteArray &out) const
+    {
+        switch (m_layout) {
+        case AResult::Layout::ArrayObject:
+            out.append('[');
+            break;
+        case AResult::Layout::ObjectArray:
+            out.append('{');
+            break;
+        case AResult::Layout::ObjectIndexed:
+            out.append("{\"columns\":");
+            writeColumns(out);
+            out.append(",\"rows\":[");
+            break;
+        case AResult::Layout::Flattened:
+            out.append("{\"columns\":");
+            writeColumns(out);
+            out.append(",\"data\":[");
+            break;
+        }
+    }
+
+    void writeUnits(QByteArray &out, int begin, int end) const
+    {
+        for (int unit = begin; unit < end; ++unit) {
+            switch (m_layout) {
+            case AResult::Layout::ArrayObject:
+                out.append(unit == begin ? "{" : ",{");
+                for (int column = 0; column < m_columns; ++column) {
+                    if (column) {
+                        out.append(',');
+                    }
+                    out.append(m_keys[column]);
+                    out.append(':');
+                    m_d->writeJsonValue(out, unit, column);
+                }
+                out.append('}');
+                break;
+            case AResult::Layout::ObjectArray:
+                if (unit != begin) {
+                    out.append(',');
+                }
+                out.append(m_keys[unit]);
+                out.append(":[");
+                for (int row = 0; row < m_rows; ++row) {
+                    if (row) {
+                        out.append(',');
+                    }
+                    m_d->writeJsonValue(out, row, unit);
+                }
+                out.append(']');
+                break;
+            case AResult::Layout::ObjectIndexed:
+                out.append(unit == begin ? "[" : ",[");
+                for (int column = 0; column < m_columns; ++column) {
+                    if (column) {
+                        out.append(',');
+                    }
+                    m_d->writeJsonValue(out, unit, column);
+                }
+                out.append(']');
+                break;
+            case AResult::Layout::Flattened:
+                for (int column = 0; column < m_columns; ++column) {
+                    if (unit != begin || column) {
+                        out.append(',');
+                    }
+                    m_d->writeJsonValue(out, unit, column);
+                }
+                break;
+            }
+        }
+    }
+
+    void writeFooter(QByteArray &out) const
+    {
+        switch (m_layout) {
+        case AResult::Layout::ArrayObject:
+            out.append(']');
+            break;
+        case AResult::Layout::ObjectArray:
+            out.append('}');
+            break;
+        case AResult::Layout::ObjectIndexed:
+            out.append("]}");
+            break;
+        case AResult::Layout::Flattened:
+            out.append("],\"rows\":");
+            out.append(QByteArray::number(m_rows));
+            out.append('}');
+            break;
+        }
+    }
+
+    static void join(QByteArray &out, const std::vector<QByteArray> &chunks)
+    {
+        qsizetype size = out.size() + qsizetype(chunks.size());
+        for (const QByteArray &chunk : chunks) {
+            size += chunk.size();
+        }
+        out.reserve(size);
+
+        bool first = true;
+        for (const QByteArray &chunk : chunks) {
+            if (chunk.isEmpty()) {
+                continue;
+            }
+            if (!std::exchange(first, false)) {
+                out.append(',');
+            }
+            out.append(chunk);
+        }
+    }
+
+private:
+    void writeColumns(QByteArray &out) const
+    {
+        out.append('[');
+        for (size_t i = 0; i < m_keys.size(); ++i) {
+            if (i) {
+                out.append(',');
+            }
+            out.append(m_keys[i]);
+        }
+        out.append(']');
+    }
+
+    const AResultPrivate *m_d;
+    std::vector<QByteArray> m_keys;
+    AResult::Layout m_layout;
+    int m_rows;
+    int m_columns;
+};
+
+} // namespace
+
+void detail::appendJsonString(QByteArray &out, QByteArrayView utf8)
+{
+    static constexpr char hex[] = "0123456789abcdef";
+
+    out.append('"');
+    qsizetype start = 0;
+    for (qsizetype i = 0; i < utf8.size(); ++i) {
+        const auto c = uchar(utf8[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        out.append(utf8.sliced(start, i - start));
+        switch (c) {
+        case '"':
+            out.append("\\\"");
+            break;
+        case '\\':
+            out.append("\\\\");
+            break;
+        case '\b':
+            out.append("\\b");
+            break;
+        case '\f':
+            out.append("\\f");
+            break;
+        case '\n':
+            out.append("\\n");
+            break;
+        case '\r':
+            out.append("\\r");
+            break;
+        case '\t':
+            out.append("\\t");
+            break;
+        default:
+            out.append("\\u00");
+            out.append(hex[c >> 4]);
+            out.append(hex[c & 0xf]);
+        }
+        start = i + 1;
+    }
+    out.append(utf8.sliced(start));
+    out.append('"');
+}
+
+void detail::appendJsonString(QByteArray &out, QStringView text)
+{
+    appendJsonString(out, text.toUtf8());
+}
+
+void detail::appendJsonNumber(QByteArray &out, double number)
+{
+    if (qIsFinite(number)) {
+        out.append(QByteArray::number(number, 'g', QLocale::FloatingPointShortest));
+    } else {
+        out.append("null");
+    }
+}
+
+void detail::appendJson(QByteArray &out, const QJsonValue &value)
+{
+    switch (value.type()) {
+    case QJsonValue::Bool:
+        out.append(value.toBool() ? "true" : "false");
+        break;
+    case QJsonValue::Double:
+        appendJsonNumber(out, value.toDouble());
+        break;
+    case QJsonValue::String:
+        appendJsonString(out, value.toString());
+        break;
+    case QJsonValue::Array:
+        out.append(QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact));
+        break;
+    case QJsonValue::Object:
+        out.append(QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact));
+        break;
+    case QJsonValue::Null:
+    case QJsonValue::Undefined:
+        out.append("null");
+        break;
+    }
+}
+
 AResult::AResult() = default;
 
 AResult::AResult(const AResult &other)
@@ -230,6 +514,205 @@ QJsonObject AResult::toJsonFlattened() const
     return ret;
 }
 
+void AResult::writeJson(QByteArray &out, Layout layout) const
+{
+    const JsonWriter writer(d.get(), layout);
+    writer.writeHeader(out);
+    writer.writeUnits(out, 0, writer.units());
+    writer.writeFooter(out);
+}
+
+void AResult::writeJsonParallel(QByteArray &out, Layout layout, QThreadPool *pool) const
+{
+    if (!pool) {
+        pool = QThreadPool::globalInstance();
+    }
+
+    const JsonWriter writer(d.get(), layout);
+    const auto ranges = writer.split(pool->maxThreadCount());
+    std::vector<QByteArray> chunks(ranges.size());
+
+    // Chunks that can't get a thread right away are written here, so this never waits
+    // on a pool that is busy, or that the caller is running on
+    QSemaphore done;
+    int started = 0;
+    for (size_t i = 1; i < ranges.size(); ++i) {
+        auto writeChunk = [&writer, &chunks, &ranges, &done, i] {
+            writer.writeUnits(chunks[i], ranges[i].first, ranges[i].second);
+            done.release();
+        };
+        if (pool->tryStart(writeChunk)) {
+            ++started;
+        } else {
+            writer.writeUnits(chunks[i], ranges[i].first, ranges[i].second);
+        }
+    }
+    if (!ranges.empty()) {
+        writer.writeUnits(chunks[0], ranges[0].first, ranges[0].second);
+    }
+    done.acquire(started);
+
+    writer.writeHeader(out);
+    JsonWriter::join(out, chunks);
+    writer.writeFooter(out);
+}
+
+ACoroExpected<QByteArray>
+    AResult::toJsonAsync(Layout layout, QObject *receiver, QThreadPool *pool) const
+{
+    ACoroExpected<QByteArray> coro(receiver);
+    if (!pool) {
+        pool = QThreadPool::globalInstance();
+    }
+
+    // Holds a copy of the result so the data outlives this object
+    struct Job {
+        Job(const AResult &_result, Layout layout)
+            : result(_result)
+            , writer(_result.d.get(), layout)
+        {
+        }
+
+        AResult result;
+        JsonWriter writer;
+        std::vector<std::pair<int, int>> ranges;
+        std::vector<QByteArray> chunks;
+        std::atomic<int> pending;
+    };
+
+    auto job     = std::make_shared<Job>(*this, layout);
+    job->ranges  = job->writer.split(pool->maxThreadCount());
+    job->chunks.resize(job->ranges.size());
+    job->pending = int(job->ranges.size());
+    if (job->ranges.empty()) {
+        QByteArray out;
+        job->writer.writeHeader(out);
+        job->writer.writeFooter(out);
+        coro.m_data->deliverDirect(std::move(out));
+        return coro;
+    }
+
+    // Delivers the document on this thread, the coroutine data ignores it
+    // if the receiver was destroyed in the meantime
+    auto context = new QObject;
+    for (size_t i = 0; i < job->ranges.size(); ++i) {
+        pool->start([job, i, context, data = coro.m_data] {
+            job->writer.writeUnits(job->chunks[i], job->ranges[i].first, job->ranges[i].second);
+            if (job->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
+            }
+
+            QMetaObject::invokeMethod(
+                context,
+                [job, context, data] {
+                    QByteArray out;
+                    job->writer.writeHeader(out);
+                    JsonWriter::join(out, job->chunks);
+                    job->writer.writeFooter(out);
+                    context->deleteLater();
+                    data->deliverDirect(std::move(out));
+                },
+                Qt::QueuedConnection);
+        });
+    }
+    return coro;
+}
+
+void AResult::writeCbor(QCborStreamWriter &writer, Layout layout) const
+{
+    const int rows    = size();
+    const int columns = fields();
+
+    std::vector<QByteArray> keys;
+    keys.reserve(columns);
+    for (int i = 0; i < columns; ++i) {
+        keys.emplace_back(fieldName(i).toUtf8());
+    }
+
+    auto writeKey = [&writer](QByteArrayView key) {
+        writer.appendTextString(key.data(), key.size());
+    };
+
+    auto writeColumns = [&keys, &writer] {
+        writer.startArray(keys.size());
+        for (const QByteArray &key : keys) {
+            writer.appendTextString(key.constData(), key.size());
+        }
+        writer.endArray();
+    };
+
+    switch (layout) {
+    case Layout::ArrayObject:
+        writer.startArray(rows);
+        for (int row = 0; row < rows; ++row) {
+            writer.startMap(columns);
+            for (int column = 0; column < columns; ++column) {
+                writeKey(keys[column]);
+                d->writeCborValue(writer, row, column);
+            }
+            writer.endMap();
+        }
+        writer.endArray();
+        break;
+    case Layout::ObjectArray:
+        writer.startMap(columns);
+        for (int column = 0; column < columns; ++column) {
+            writeKey(keys[column]);
+            writer.startArray(rows);
+            for (int row = 0; row < rows; ++row) {
+                d->writeCborValue(writer, row, column);
+            }
+            writer.endArray();
+        }
+        writer.endMap();
+        break;
+    case Layout::ObjectIndexed:
+        writer.startMap(2);
+        writer.append("columns"_L1);
+        writeColumns();
+        writer.append("rows"_L1);
+        writer.startArray(rows);
+        for (int row = 0; row < rows; ++row) {
+            writer.startArray(columns);
+            for (int column = 0; column < columns; ++column) {
+                d->writeCborValue(writer, row, column);
+            }
+            writer.endArray();
+        }
+        writer.endArray();
+        writer.endMap();
+        break;
+    case Layout::Flattened:
+        writer.startMap(3);
+        writer.append("columns"_L1);
+        writeColumns();
+        writer.append("rows"_L1);
+        writer.append(qint64(rows));
+        writer.append("data"_L1);
+        writer.startArray(quint64(rows) * quint64(columns));
+        for (int row = 0; row < rows; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                d->writeCborValue(writer, row, column);
+            }
+        }
+        writer.endArray();
+        writer.endMap();
+        break;
+    }
+}
+
+void AResult::writeCbor(QIODevice *device, Layout layout) const
+{
+    QCborStreamWriter writer(device);
+    writeCbor(writer, layout);
+}
+
+void AResult::writeCbor(QByteArray &out, Layout layout) const
+{
+    QCborStreamWriter writer(&out);
+    writeCbor(writer, layout);
+}
+
 QCborArray AResult::toCborArrayMap() const
 {
     QCborArray ret;
@@ -335,36 +818,197 @@ AResult::AResult(std::shared_ptr<AResultPrivate> &&priv)
 {
 }
 
+// Open addressing hash of the column names, probed linearly so that
+// duplicated names resolve to the first column like a plain loop would
+class AResultPrivate::FieldIndex
+{
+public:
+    explicit FieldIndex(const AResultPrivate *result)
+    {
+        const int count = result->fields();
+        size_t capacity = 8;
+        while (capacity < size_t(count) * 2) {
+            capacity <<= 1;
+        }
+        m_slots.resize(capacity);
+        m_names.reserve(count);
+
+        for (int i = 0; i < count; ++i) {
+            m_names.append(result->fieldName(i));
+            const size_t hash = qHash(QStringView(m_names.last()));
+            size_t pos        = hash & (capacity - 1);
+            while (m_slots[pos].column != -1) {
+                pos = (pos + 1) & (capacity - 1);
+            }
+            m_slots[pos] = {hash, i};
+        }
+    }
+
+    int find(QStringView name) const
+    {
+        const size_t mask = m_slots.size() - 1;
+        const size_t hash = qHash(name);
+        for (size_t pos = hash & mask; m_slots[pos].column != -1; pos = (pos + 1) & mask) {
+            const Slot &slot = m_slots[pos];
+            if (slot.hash == hash && m_names[slot.column] == name) {
+                return slot.column;
+            }
+        }
+        return -1;
+    }
+
+private:
+    struct Slot {
+        size_t hash = 0;
+        int column  = -1;
+    };
+
+    std::vector<Slot> m_slots;
+    QStringList m_names;
+};
+
 AResultPrivate::~AResultPrivate() = default;
 
-int AResultPrivate::indexOfField(const QString &name) const
+void AResultPrivate::columnInto(int column, std::span<int> out, std::span<quint64> nulls) const
 {
-    for (int i = 0; i < fields(); ++i) {
-        if (name == fieldName(i)) {
-            return i;
+    fillColumn(this, column, out, nulls, [this, column](int row) { return toInt(row, column); });
+}
+
+void AResultPrivate::columnInto(int column, std::span<qint64> out, std::span<quint64> nulls) const
+{
+    fillColumn(this, column, out, nulls, [this, column](int row) {
+        return toLongLong(row, column);
+    });
+}
+
+void AResultPrivate::columnInto(int column, std::span<double> out, std::span<quint64> nulls) const
+{
+    fillColumn(this, column, out, nulls, [this, column](int row) {
+        return toDouble(row, column);
+    });
+}
+
+void AResultPrivate::columnInto(int column,
+                                std::span<QString> out,
+                                std::span<quint64> nulls) const
+{
+    fillColumn(this, column, out, nulls, [this, column](int row) {
+        return toString(row, column);
+    });
+}
+
+QMetaType AResultPrivate::columnType(int column) const
+{
+    for (int row = 0; row < size(); ++row) {
+        if (!isNull(row, column)) {
+            return value(row, column).metaType();
         }
     }
-    return -1;
+    return {};
 }
 
-int AResultPrivate::indexOfField(QStringView name) const
+void AResultPrivate::writeJsonValue(QByteArray &out, int row, int column) const
 {
-    for (int i = 0; i < fields(); ++i) {
-        if (name == fieldName(i)) {
-            return i;
-        }
+    const QVariant data = value(row, column);
+    if (data.isNull()) {
+        out.append("null");
+        return;
+    }
+
+    switch (data.typeId()) {
+    case QMetaType::Bool:
+        out.append(data.toBool() ? "true" : "false");
+        break;
+    case QMetaType::Short:
+    case QMetaType::Int:
+    case QMetaType::Long:
+    case QMetaType::LongLong:
+        out.append(QByteArray::number(data.toLongLong()));
+        break;
+    case QMetaType::UShort:
+    case QMetaType::UInt:
+    case QMetaType::ULong:
+    case QMetaType::ULongLong:
+        out.append(QByteArray::number(data.toULongLong()));
+        break;
+    case QMetaType::Float:
+    case QMetaType::Double:
+        detail::appendJsonNumber(out, data.toDouble());
+        break;
+    case QMetaType::QString:
+        detail::appendJsonString(out, data.toString());
+        break;
+    case QMetaType::QByteArray:
+        detail::appendJsonString(out, data.toByteArray());
+        break;
+    default:
+        detail::appendJson(out, QJsonValue::fromVariant(data));
     }
-    return -1;
+}
+
+void AResultPrivate::writeCborValue(QCborStreamWriter &writer, int row, int column) const
+{
+    const QVariant data = value(row, column);
+    if (data.isNull()) {
+        writer.append(nullptr);
+        return;
+    }
+
+    switch (data.typeId()) {
+    case QMetaType::Bool:
+        writer.append(data.toBool());
+        break;
+    case QMetaType::Short:
+    case QMetaType::Int:
+    case QMetaType::Long:
+    case QMetaType::LongLong:
+        writer.append(data.toLongLong());
+        break;
+    case QMetaType::UShort:
+    case QMetaType::UInt:
+    case QMetaType::ULong:
+    case QMetaType::ULongLong:
+        writer.append(data.toULongLong());
+        break;
+    case QMetaType::Float:
+    case QMetaType::Double:
+        writer.append(data.toDouble());
+        break;
+    case QMetaType::QString:
+        writer.append(data.toString());
+        break;
+    case QMetaType::QByteArray:
+        writer.append(data.toByteArray());
+        break;
+    default:
+        QCborValue::fromVariant(data).toCbor(writer);
+    }
+}
+
+int AResultPrivate::fieldIndex(QStringView name) const
+{
+    std::call_once(m_fieldIndexOnce,
+                   [this] { m_fieldIndex = std::make_unique<FieldIndex>(this); });
+    return m_fieldIndex->find(name);
+}
+
+int AResultPrivate::indexOfField(const QString &name) const
+{
+    return fieldIndex(name);
+}
+
+int AResultPrivate::indexOfField(QStringView name) const
+{
+    return fieldIndex(name);
 }
 
 int AResultPrivate::indexOfField(QLatin1String name) const
 {
-    for (int i = 0; i < fields(); ++i) {
-        if (name == fieldName(i)) {
-            return i;
-        }
+    QVarLengthArray<char16_t, 64> utf16(name.size());
+    for (qsizetype i = 0; i < name.size(); ++i) {
+        utf16[i] = char16_t(uchar(name.data()[i]));
     }
-    return -1;
+    return fieldIndex(QStringView(utf16.constData(), utf16.size()));
 }
 
 QUuid AResult::AColumn::toUuid() const
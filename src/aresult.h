@@ -6,10 +6,13 @@
 
 #include <asql_export.h>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <QCborValue>
 #include <QDate>
@@ -18,8 +21,15 @@
 #include <QTime>
 #include <QVariant>
 
+class QCborStreamWriter;
+class QIODevice;
+class QThreadPool;
+
 namespace ASql {
 
+template <typename T>
+class ACoroExpected;
+
 namespace detail {
 
 template <typename T>
@@ -30,6 +40,37 @@ template <typename T>
 struct is_optional<std::optional<T>> : std::true_type {
 };
 
+template <typename T>
+inline constexpr bool is_bulk_column = std::is_same_v<T, int> || std::is_same_v<T, qint64> ||
+                                       std::is_same_v<T, double> || std::is_same_v<T, QString>;
+
+/*!
+ * Sets or clears the \p row bit of a NULL bitmap, nothing is done if \p nulls is empty
+ */
+inline void setNullBit(std::span<quint64> nulls, size_t row, bool null)
+{
+    if (!nulls.empty()) {
+        const quint64 mask = quint64(1) << (row & 63);
+        nulls[row >> 6]    = null ? (nulls[row >> 6] | mask) : (nulls[row >> 6] & ~mask);
+    }
+}
+
+/*!
+ * Appends \p utf8 to \p out as a quoted and escaped JSON string
+ */
+ASQL_EXPORT void appendJsonString(QByteArray &out, QByteArrayView utf8);
+ASQL_EXPORT void appendJsonString(QByteArray &out, QStringView text);
+
+/*!
+ * Appends \p number to \p out as a JSON number, NaN and infinities are written as null
+ */
+ASQL_EXPORT void appendJsonNumber(QByteArray &out, double number);
+
+/*!
+ * Appends \p value to \p out as compact JSON
+ */
+ASQL_EXPORT void appendJson(QByteArray &out, const QJsonValue &value);
+
 } // namespace detail
 
 class ASQL_EXPORT AResultPrivate
@@ -69,11 +110,175 @@ public:
     virtual QJsonValue toJsonValue(int row, int column) const  = 0;
     virtual QCborValue toCborValue(int row, int column) const  = 0;
     virtual QByteArray toByteArray(int row, int column) const  = 0;
+
+    /*!
+     * \brief columnInto converts the first out.size() values of \p column in a single pass
+     *
+     * NULL values are set to a default constructed value, and their bit is set on \p nulls
+     * when it's not empty. The default implementation calls the per cell methods, drivers
+     * reimplement them to avoid a virtual call per value.
+     */
+    virtual void columnInto(int column, std::span<int> out, std::span<quint64> nulls) const;
+    virtual void columnInto(int column, std::span<qint64> out, std::span<quint64> nulls) const;
+    virtual void columnInto(int column, std::span<double> out, std::span<quint64> nulls) const;
+    virtual void columnInto(int column, std::span<QString> out, std::span<quint64> nulls) const;
+
+    /*!
+     * \brief columnType returns the type of the values of \p column
+     *
+     * The default implementation returns the type of the first value that is not NULL,
+     * or an invalid type if there is none.
+     */
+    virtual QMetaType columnType(int column) const;
+
+    /*!
+     * \brief writeJsonValue appends the value at \p row and \p column to \p out as JSON
+     *
+     * The default implementation converts the value() like QJsonValue::fromVariant() does,
+     * drivers reimplement it to write numbers and strings straight from their own storage.
+     */
+    virtual void writeJsonValue(QByteArray &out, int row, int column) const;
+
+    /*!
+     * \brief writeCborValue encodes the value at \p row and \p column with \p writer
+     *
+     * NULL values are encoded as CBOR null, the default implementation converts other values
+     * like QCborValue::fromVariant() does.
+     */
+    virtual void writeCborValue(QCborStreamWriter &writer, int row, int column) const;
+
+protected:
+    /*!
+     * \brief variantColumnInto implements \sa columnInto() for results that store their
+     * values as a flat row major QVariantList
+     */
+    template <typename T>
+    static void variantColumnInto(const QVariantList &rows,
+                                  qsizetype fields,
+                                  int column,
+                                  std::span<T> out,
+                                  std::span<quint64> nulls)
+    {
+        for (size_t row = 0; row < out.size(); ++row) {
+            const QVariant &value = rows.at(qsizetype(row) * fields + column);
+            const bool null       = value.isNull();
+            detail::setNullBit(nulls, row, null);
+            out[row] = null ? T{} : qvariant_cast<T>(value);
+        }
+    }
+
+    /*!
+     * \brief fieldIndex looks up the column \p name in a hash of the column names
+     *
+     * The hash is built once on the first lookup and shared by all rows of the result,
+     * it's used by the default \sa indexOfField() implementations.
+     *
+     * \return the first column named \p name or -1
+     */
+    int fieldIndex(QStringView name) const;
+
+private:
+    class FieldIndex;
+    mutable std::once_flag m_fieldIndexOnce;
+    mutable std::unique_ptr<FieldIndex> m_fieldIndex;
 };
 
+/*!
+ * \brief AColumnRef is a column index resolved once, see \sa AResult::columnRef()
+ *
+ * Resolving the column outside a loop avoids looking up the name on every row:
+ * \code
+ * const auto price = result.columnRef(u"price");
+ * for (auto row : result) {
+ *     total += row[price].toDouble();
+ * }
+ * \endcode
+ */
+class AColumnRef
+{
+public:
+    constexpr AColumnRef() = default;
+    constexpr explicit AColumnRef(int column)
+        : m_column(column)
+    {
+    }
+
+    [[nodiscard]] constexpr int index() const { return m_column; }
+    [[nodiscard]] constexpr bool isValid() const { return m_column >= 0; }
+
+private:
+    int m_column = -1;
+};
+
+/*!
+ * \brief AFieldBinding binds a member of T to a result column, see \sa ARowMapping
+ */
+template <typename T, typename M>
+struct AFieldBinding {
+    M T::*member;
+    int column = -1;
+    QStringView name;
+};
+
+/*!
+ * \brief ABind binds \p member to the column at \p column index
+ */
+template <typename T, typename M>
+constexpr AFieldBinding<T, M> ABind(M T::*member, int column)
+{
+    return {member, column, {}};
+}
+
+/*!
+ * \brief ABind binds \p member to the column named \p name, which is resolved once per result
+ */
+template <typename T, typename M>
+constexpr AFieldBinding<T, M> ABind(M T::*member, QStringView name)
+{
+    return {member, -1, name};
+}
+
+/*!
+ * \brief ARowMapping declares how the columns of a result map to the members of T
+ *
+ * Specialize it with a tuple of \sa ABind() to use \sa AResult::toVector():
+ * \code
+ * struct Person {
+ *     qint64 id;
+ *     QString name;
+ *     std::optional<int> age;
+ * };
+ *
+ * template <>
+ * struct ASql::ARowMapping<Person> {
+ *     static constexpr std::tuple fields{
+ *         ABind(&Person::id, 0),
+ *         ABind(&Person::name, u"name"),
+ *         ABind(&Person::age, u"age"),
+ *     };
+ * };
+ * \endcode
+ */
+template <typename T>
+struct ARowMapping;
+
 class ASQL_EXPORT AResult
 {
 public:
+    /*!
+     * \brief Layout selects how all rows of a result are serialized
+     */
+    enum class Layout {
+        /*! [ {"col1": 1, "col2": "foo"}, {"col1": 2, "col2": "bar"} ] */
+        ArrayObject,
+        /*! { "col1": [1, 2], "col2": ["foo", "bar"] } */
+        ObjectArray,
+        /*! { "columns": ["col1", "col2"], "rows": [ [1, "foo"], [2, "bar"] ] } */
+        ObjectIndexed,
+        /*! { "columns": ["col1", "col2"], "data": [ 1, "foo", 2, "bar" ], "rows": 2 } */
+        Flattened,
+    };
+
     AResult();
     AResult(const std::shared_ptr<AResultPrivate> &priv);
     AResult(std::shared_ptr<AResultPrivate> &&priv);
@@ -104,6 +309,71 @@ public:
     [[nodiscard]] int indexOfField(QStringView name) const;
     [[nodiscard]] QString fieldName(int column) const;
 
+    /*!
+     * \brief columnRef resolves the column \p name to be used on the rows of this result
+     * \return an invalid reference if there is no such column
+     */
+    [[nodiscard]] inline AColumnRef columnRef(QStringView name) const
+    {
+        return AColumnRef(d->indexOfField(name));
+    }
+    [[nodiscard]] inline AColumnRef columnRef(QLatin1String name) const
+    {
+        return AColumnRef(d->indexOfField(name));
+    }
+
+    /*!
+     * \brief column returns all values of \p column converted to T
+     *
+     * T can be int, qint64, double or QString, drivers convert the whole column in a single
+     * tight loop instead of a virtual call per cell, giving a contiguous vector.
+     *
+     * \param nulls if not null receives a bitmap with one bit per row, set for NULL values
+     */
+    template <typename T>
+    [[nodiscard]] std::vector<T> column(int column, std::vector<quint64> *nulls = nullptr) const
+    {
+        std::vector<T> ret(size_t(size()));
+        std::span<quint64> bits;
+        if (nulls) {
+            nulls->assign((ret.size() + 63) / 64, 0);
+            bits = *nulls;
+        }
+        d->columnInto(column, std::span<T>(ret), bits);
+        return ret;
+    }
+
+    /*!
+     * \brief columnInto same as \sa column() but writes the values into \p out
+     *
+     * \p out must have room for size() values and \p nulls, if not empty, for size() bits.
+     */
+    template <typename T>
+    void columnInto(std::span<T> out, int column, std::span<quint64> nulls = {}) const
+    {
+        const auto rows = size_t(size());
+        Q_ASSERT_X(out.size() >= rows, "columnInto", "output span is too small");
+        Q_ASSERT_X(nulls.empty() || nulls.size() * 64 >= rows, "columnInto", "nulls too small");
+        d->columnInto(column, out.first(rows), nulls);
+    }
+
+    /*!
+     * \brief toVector returns all rows converted to T using the bindings of \sa ARowMapping<T>
+     *
+     * Column names are resolved once, and members of type int, qint64, double and QString, or
+     * std::optional of them, are filled a whole column at a time with \sa columnInto(), other
+     * members are converted with \sa AColumn::as(). T must be default constructible,
+     * members bound to a missing column are left untouched.
+     */
+    template <typename T>
+    [[nodiscard]] std::vector<T> toVector() const
+    {
+        std::vector<T> ret(size_t(size()));
+        std::apply([this, &ret](const auto &...binding) { (fillMember(ret, binding), ...); },
+                   ARowMapping<T>::fields);
+        return ret;
+    }
+
     /*!
      * \brief columnNames returns the column names
      * \return
@@ -174,6 +444,66 @@ public:
      */
     [[nodiscard]] QJsonObject toJsonFlattened() const;
 
+    /*!
+     * \brief writeJson appends all rows to \p out as compact UTF-8 JSON in the given \p layout
+     *
+     * This produces the same document as the matching toJson*() method without building a
+     * QJsonObject first, values are written directly from the driver data, column keys are
+     * escaped only once and PostgreSQL json and jsonb values are copied verbatim. Unlike
+     * QJsonObject the columns keep the order of the query.
+     */
+    void writeJson(QByteArray &out, Layout layout = Layout::ArrayObject) const;
+
+    /*!
+     * \brief writeJsonParallel same as \sa writeJson() but large results are split in row
+     * ranges that are written concurrently on \p pool, or the global pool if null
+     *
+     * Ranges that can't get a free thread are written by the caller, which blocks until the
+     * document is complete.
+     */
+    void writeJsonParallel(QByteArray &out,
+                           Layout layout     = Layout::ArrayObject,
+                           QThreadPool *pool = nullptr) const;
+
+    /*!
+     * \brief toJsonAsync writes the JSON document like \sa writeJsonParallel() without
+     * blocking the calling thread, the coroutine is resumed on this thread once it's done
+     *
+     * \code
+     * auto json = co_await result.toJsonAsync(AResult::Layout::Flattened, this);
+     * \endcode
+     *
+     * The result data is shared with the worker threads, which only read it.
+     */
+    [[nodiscard]] ACoroExpected<QByteArray> toJsonAsync(Layout layout     = Layout::ArrayObject,
+                                                        QObject *receiver = nullptr,
+                                                        QThreadPool *pool = nullptr) const;
+
+    /*!
+     * \brief writeArrowIpc writes all rows to \p device as an Apache Arrow IPC stream
+     *
+     * The stream has the schema followed by record batches of up to 65536 rows, which can
+     * be read by pyarrow, pandas, Polars or DuckDB. Integers, doubles and strings are
+     * extracted a column at a time with \sa column(), dates are written as date32, times
+     * as time32 in milliseconds and date times as UTC timestamps in milliseconds, other
+     * types are written as UTF-8 strings.
+     *
+     * \return false if the result has an error or writing to \p device failed
+     */
+    bool writeArrowIpc(QIODevice *device) const;
+
+    /*!
+     * \brief writeCbor encodes all rows with \p writer in the given \p layout
+     *
+     * This produces the same document as the matching toCbor*() method, except that NULL
+     * values are encoded as null, without building a QCborMap or QCborArray first, so the
+     * result is walked once and integers, doubles, text and byte strings are encoded
+     * directly from the driver data.
+     */
+    void writeCbor(QCborStreamWriter &writer, Layout layout = Layout::ArrayObject) const;
+    void writeCbor(QIODevice *device, Layout layout = Layout::ArrayObject) const;
+    void writeCbor(QByteArray &out, Layout layout = Layout::ArrayObject) const;
+
     /*!
      * \brief toCborArrayMap returns all rows as an array of Cbor maps.
      * \return
@@ -209,14 +539,19 @@ public:
     AResult &operator=(const AResult &copy);
     bool operator==(const AResult &other) const;
 
+    /*!
+     * AColumn, ARow and const_iterator are lightweight views that point to the data of the
+     * AResult they come from without holding a reference to it, so iterating does no atomic
+     * reference counting, they must not outlive the AResult object they were created from.
+     */
     class ASQL_EXPORT AColumn
     {
     public:
-        std::shared_ptr<AResultPrivate> d;
+        const AResultPrivate *d = nullptr;
         int row;
         int column;
 
-        explicit inline AColumn(std::shared_ptr<AResultPrivate> data, int _row, int _column)
+        explicit inline AColumn(const AResultPrivate *data, int _row, int _column)
             : d(data)
             , row(_row)
             , column(_column)
@@ -297,10 +632,10 @@ public:
     class ASQL_EXPORT ARow
     {
     public:
-        std::shared_ptr<AResultPrivate> d;
+        const AResultPrivate *d = nullptr;
         int row;
 
-        explicit inline ARow(std::shared_ptr<AResultPrivate> data, int index)
+        explicit inline ARow(const AResultPrivate *data, int index)
             : d(data)
             , row(index)
         {
@@ -347,11 +682,21 @@ public:
             return d->value(row, d->indexOfField(name));
         }
 
+        [[nodiscard]] inline QVariant value(AColumnRef column) const
+        {
+            return d->value(row, column.index());
+        }
+
         [[nodiscard]] inline AColumn operator[](int column) const
         {
             return AColumn(d, row, column);
         }
 
+        [[nodiscard]] inline AColumn operator[](AColumnRef column) const
+        {
+            return AColumn(d, row, column.index());
+        }
+
         [[nodiscard]] inline AColumn operator[](const QString &name) const
         {
             return AColumn(d, row, d->indexOfField(name));
@@ -391,7 +736,7 @@ public:
     class ASQL_EXPORT const_iterator
     {
     public:
-        std::shared_ptr<AResultPrivate> d;
+        const AResultPrivate *d = nullptr;
         int i;
         using iterator_category = std::random_access_iterator_tag;
         using value_type        = ARow;
@@ -401,7 +746,7 @@ public:
             : i(0)
         {
         }
-        explicit inline const_iterator(std::shared_ptr<AResultPrivate> data, int index)
+        explicit inline const_iterator(const AResultPrivate *data, int index)
             : d(data)
             , i(index)
         {
@@ -451,8 +796,18 @@ public:
             return d->value(i, d->indexOfField(name));
         }
 
+        [[nodiscard]] inline QVariant value(AColumnRef column) const
+        {
+            return d->value(i, column.index());
+        }
+
         [[nodiscard]] inline AColumn operator[](int column) const { return AColumn(d, i, column); }
 
+        [[nodiscard]] inline AColumn operator[](AColumnRef column) const
+        {
+            return AColumn(d, i, column.index());
+        }
+
         [[nodiscard]] inline AColumn operator[](const QString &name) const
         {
             return AColumn(d, i, d->indexOfField(name));
@@ -519,15 +874,49 @@ public:
     friend class const_iterator;
 
     // stl style
-    inline const_iterator begin() const { return const_iterator(d, 0); }
-    inline const_iterator constBegin() const { return const_iterator(d, 0); }
-    inline const_iterator end() const { return const_iterator(d, size()); }
-    inline const_iterator constEnd() const { return const_iterator(d, size()); }
+    inline const_iterator begin() const { return const_iterator(d.get(), 0); }
+    inline const_iterator constBegin() const { return const_iterator(d.get(), 0); }
+    inline const_iterator end() const { return const_iterator(d.get(), size()); }
+    inline const_iterator constEnd() const { return const_iterator(d.get(), size()); }
 
-    [[nodiscard]] inline ARow operator[](int row) const { return ARow(d, row); }
+    [[nodiscard]] inline ARow operator[](int row) const { return ARow(d.get(), row); }
 
 protected:
     std::shared_ptr<AResultPrivate> d;
+
+private:
+    template <typename T, typename M>
+    void fillMember(std::vector<T> &rows, const AFieldBinding<T, M> &binding) const
+    {
+        const int column = binding.name.isNull() ? binding.column : d->indexOfField(binding.name);
+        if (column < 0 || column >= fields()) {
+            return;
+        }
+
+        if constexpr (detail::is_bulk_column<M>) {
+            std::vector<M> values(rows.size());
+            d->columnInto(column, std::span<M>(values), {});
+            for (size_t i = 0; i < rows.size(); ++i) {
+                rows[i].*binding.member = std::move(values[i]);
+            }
+        } else if constexpr (detail::is_optional<M>::value &&
+                             detail::is_bulk_column<typename M::value_type>) {
+            std::vector<typename M::value_type> values(rows.size());
+            std::vector<quint64> nulls((rows.size() + 63) / 64);
+            d->columnInto(column, std::span<typename M::value_type>(values), nulls);
+            for (size_t i = 0; i < rows.size(); ++i) {
+                if (nulls[i >> 6] & (quint64(1) << (i & 63))) {
+                    rows[i].*binding.member = std::nullopt;
+                } else {
+                    rows[i].*binding.member = std::move(values[i]);
+                }
+            }
+        } else {
+            for (size_t i = 0; i < rows.size(); ++i) {
+                rows[i].*binding.member = AColumn(d.get(), int(i), column).template as<M>();
+            }
+        }
+    }
 };
 
 #define AColumnIndex(result, columnName) \
@@ -0,0 +1,607 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2025 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "aresult.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <functional>
+
+#include <QIODevice>
+#include <QtEndian>
+
+using namespace ASql;
+
+namespace {
+
+// Rows written per record batch, keeps the memory used by large results bounded
+constexpr int arrowBatchRows = 64 * 1024;
+
+// Type union values of Schema.fbs
+enum ArrowType : quint8 {
+    ArrowNull      = 1,
+    ArrowInt       = 2,
+    ArrowFloat     = 3,
+    ArrowBinary    = 4,
+    ArrowUtf8      = 5,
+    ArrowBool      = 6,
+    ArrowDate      = 8,
+    ArrowTime      = 9,
+    ArrowTimestamp = 10,
+};
+
+// MessageHeader union values of Message.fbs
+enum ArrowMessage : quint8 {
+    ArrowSchema      = 1,
+    ArrowRecordBatch = 3,
+};
+
+constexpr qint16 arrowMetadataV5 = 4;
+
+/*!
+ * A minimal FlatBuffers builder, like the official one the buffer is built from
+ * the end to the front, so objects are referenced by their distance to the end
+ */
+class FlatBufferBuilder
+{
+public:
+    quint32 size() const { return quint32(m_buf.size()); }
+
+    template <typename T>
+    void push(T value)
+    {
+        align(sizeof(T));
+        value = qToLittleEndian(value);
+        prepend(&value, sizeof(T));
+    }
+
+    quint32 pushOffset(quint32 ref)
+    {
+        align(sizeof(quint32));
+        const quint32 relative = qToLittleEndian(size() + quint32(sizeof(quint32)) - ref);
+        prepend(&relative, sizeof(quint32));
+        return size();
+    }
+
+    quint32 createString(QByteArrayView string)
+    {
+        align(sizeof(quint32), string.size() + 1);
+        const char zero = 0;
+        prepend(&zero, 1);
+        prepend(string.data(), string.size());
+        push(quint32(string.size()));
+        return size();
+    }
+
+    quint32 createOffsetVector(const std::vector<quint32> &refs)
+    {
+        align(sizeof(quint32), refs.size() * sizeof(quint32));
+        for (auto it = refs.rbegin(); it != refs.rend(); ++it) {
+            pushOffset(*it);
+        }
+        push(quint32(refs.size()));
+        return size();
+    }
+
+    // Vector of structs made of two longs, like FieldNode and Buffer
+    quint32 createPairVector(const std::vector<std::pair<qint64, qint64>> &pairs)
+    {
+        const size_t bytes = pairs.size() * 2 * sizeof(qint64);
+        align(sizeof(quint32), bytes);
+        align(sizeof(qint64), bytes);
+        for (auto it = pairs.rbegin(); it != pairs.rend(); ++it) {
+            push(it->second);
+            push(it->first);
+        }
+        push(quint32(pairs.size()));
+        return size();
+    }
+
+    void startTable()
+    {
+        m_fields.clear();
+        m_tableEnd = size();
+    }
+
+    template <typename T>
+    void addScalar(int slot, T value)
+    {
+        push(value);
+        m_fields.emplace_back(slot, size());
+    }
+
+    void addOffset(int slot, quint32 ref)
+    {
+        pushOffset(ref);
+        m_fields.emplace_back(slot, size());
+    }
+
+    quint32 endTable()
+    {
+        push(qint32(0));
+        const quint32 table = size();
+
+        int slots = 0;
+        for (const auto &[slot, offset] : m_fields) {
+            slots = std::max(slots, slot + 1);
+        }
+        std::vector<quint16> vtable(slots, 0);
+        for (const auto &[slot, offset] : m_fields) {
+            vtable[slot] = quint16(table - offset);
+        }
+
+        for (auto it = vtable.rbegin(); it != vtable.rend(); ++it) {
+            push(*it);
+        }
+        push(quint16(table - m_tableEnd));
+        push(quint16((slots + 2) * sizeof(quint16)));
+
+        // The table starts with the signed distance back to its vtable
+        const qint32 vtableDistance = qToLittleEndian(qint32(size() - table));
+        memcpy(m_buf.data() + (size() - table), &vtableDistance, sizeof(qint32));
+        return table;
+    }
+
+    QByteArray finish(quint32 root)
+    {
+        align(m_maxAlign, sizeof(quint32));
+        pushOffset(root);
+        return QByteArray(reinterpret_cast<const char *>(m_buf.data()), qsizetype(m_buf.size()));
+    }
+
+private:
+    void align(size_t alignment, size_t extra = 0)
+    {
+        m_maxAlign = std::max(m_maxAlign, alignment);
+        const size_t padding = (alignment - ((m_buf.size() + extra) % alignment)) % alignment;
+        m_buf.insert(m_buf.begin(), padding, 0);
+    }
+
+    void prepend(const void *data, size_t len)
+    {
+        const auto bytes = static_cast<const quint8 *>(data);
+        m_buf.insert(m_buf.begin(), bytes, bytes + len);
+    }
+
+    std::vector<quint8> m_buf;
+    std::vector<std::pair<int, quint32>> m_fields;
+    size_t m_maxAlign  = 1;
+    quint32 m_tableEnd = 0;
+};
+
+struct ArrowColumn {
+    QByteArray name;
+    ArrowType type = ArrowNull;
+    QMetaType metaType;
+    int bitWidth  = 0;
+    bool isSigned = true;
+};
+
+ArrowColumn arrowColumn(const AResultPrivate *d, int column)
+{
+    ArrowColumn ret{.name = d->fieldName(column).toUtf8(), .metaType = d->columnType(column)};
+    switch (ret.metaType.id()) {
+    case QMetaType::Bool:
+        ret.type = ArrowBool;
+        break;
+    case QMetaType::Char:
+    case QMetaType::SChar:
+    case QMetaType::UChar:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+    case QMetaType::Int:
+        ret.type     = ArrowInt;
+        ret.bitWidth = 32;
+        break;
+    case QMetaType::UInt:
+    case QMetaType::Long:
+    case QMetaType::LongLong:
+        ret.type     = ArrowInt;
+        ret.bitWidth = 64;
+        break;
+    case QMetaType::ULong:
+    case QMetaType::ULongLong:
+        ret.type     = ArrowInt;
+        ret.bitWidth = 64;
+        ret.isSigned = false;
+        break;
+    case QMetaType::Float:
+    case QMetaType::Double:
+        ret.type = ArrowFloat;
+        break;
+    case QMetaType::QByteArray:
+        ret.type = ArrowBinary;
+        break;
+    case QMetaType::QDate:
+        ret.type = ArrowDate;
+        break;
+    case QMetaType::QTime:
+        ret.type = ArrowTime;
+        break;
+    case QMetaType::QDateTime:
+        ret.type = ArrowTimestamp;
+        break;
+    case QMetaType::UnknownType:
+    {
+        // Unknown or mixed types, only columns without any value are kept as null
+        ret.type = ArrowNull;
+        for (int row = 0; row < d->size(); ++row) {
+            if (!d->isNull(row, column)) {
+                ret.type = ArrowUtf8;
+                break;
+            }
+        }
+        break;
+    }
+    default:
+        // Strings and anything else that has a text representation
+        ret.type = ArrowUtf8;
+        break;
+    }
+    return ret;
+}
+
+quint32 arrowFieldType(FlatBufferBuilder &fbb, const ArrowColumn &column)
+{
+    switch (column.type) {
+    case ArrowInt:
+        fbb.startTable();
+        fbb.addScalar(0, qint32(column.bitWidth));
+        fbb.addScalar(1, quint8(column.isSigned));
+        return fbb.endTable();
+    case ArrowFloat:
+        fbb.startTable();
+        fbb.addScalar(0, qint16(2)); // DOUBLE
+        return fbb.endTable();
+    case ArrowDate:
+        fbb.startTable();
+        fbb.addScalar(0, qint16(0)); // DAY
+        return fbb.endTable();
+    case ArrowTime:
+        fbb.startTable();
+        fbb.addScalar(1, qint32(32));
+        fbb.addScalar(0, qint16(1)); // MILLISECOND
+        return fbb.endTable();
+    case ArrowTimestamp:
+    {
+        const quint32 timezone = fbb.createString("UTC");
+        fbb.startTable();
+        fbb.addOffset(1, timezone);
+        fbb.addScalar(0, qint16(1)); // MILLISECOND
+        return fbb.endTable();
+    }
+    default:
+        // Null, Bool, Binary and Utf8 have no properties
+        fbb.startTable();
+        return fbb.endTable();
+    }
+}
+
+QByteArray arrowMessage(FlatBufferBuilder &fbb, ArrowMessage type, quint32 header, qint64 body)
+{
+    fbb.startTable();
+    fbb.addScalar(3, body);
+    fbb.addOffset(2, header);
+    fbb.addScalar(0, arrowMetadataV5);
+    fbb.addScalar(1, quint8(type));
+    return fbb.finish(fbb.endTable());
+}
+
+QByteArray arrowSchema(const std::vector<ArrowColumn> &columns)
+{
+    FlatBufferBuilder fbb;
+
+    std::vector<quint32> fields;
+    fields.reserve(columns.size());
+    const quint32 noChildren = fbb.createOffsetVector({});
+    for (const ArrowColumn &column : columns) {
+        const quint32 name = fbb.createString(column.name);
+        const quint32 type = arrowFieldType(fbb, column);
+
+        fbb.startTable();
+        fbb.addOffset(0, name);
+        fbb.addOffset(3, type);
+        fbb.addOffset(5, noChildren);
+        fbb.addScalar(1, quint8(1)); // nullable
+        fbb.addScalar(2, quint8(column.type));
+        fields.push_back(fbb.endTable());
+    }
+    const quint32 fieldsVector = fbb.createOffsetVector(fields);
+
+    fbb.startTable();
+    fbb.addOffset(1, fieldsVector);
+    const quint32 schema = fbb.endTable();
+
+    return arrowMessage(fbb, ArrowSchema, schema, 0);
+}
+
+// Accumulates the body buffers of a record batch
+struct ArrowBody {
+    void addNode(qint64 length, qint64 nullCount) { nodes.emplace_back(length, nullCount); }
+
+    void addBuffer(QByteArrayView data)
+    {
+        buffers.emplace_back(body.size(), data.size());
+        body.append(data);
+        body.append(QByteArray((8 - body.size() % 8) % 8, '\0'));
+    }
+
+    // Adds the validity bitmap from a NULL bitmap, returning the number of NULL values
+    qint64 addValidity(std::span<const quint64> nulls, int rows)
+    {
+        qint64 nullCount = 0;
+        for (const quint64 word : nulls) {
+            nullCount += std::popcount(word);
+        }
+
+        if (nullCount == 0) {
+            addBuffer({});
+            return 0;
+        }
+
+        QByteArray validity((rows + 7) / 8, '\0');
+        for (int row = 0; row < rows; ++row) {
+            if (!(nulls[row >> 6] & (quint64(1) << (row & 63)))) {
+                validity[row >> 3] = char(validity[row >> 3] | (1 << (row & 7)));
+            }
+        }
+        addBuffer(validity);
+        return nullCount;
+    }
+
+    std::vector<std::pair<qint64, qint64>> nodes;
+    std::vector<std::pair<qint64, qint64>> buffers;
+    QByteArray body;
+};
+
+template <typename T>
+QByteArrayView arrowBytes(const std::vector<T> &values)
+{
+    return QByteArrayView(reinterpret_cast<const char *>(values.data()),
+                          qsizetype(values.size() * sizeof(T)));
+}
+
+// Fills \p nulls for the columns that are converted value by value
+template <typename T, typename Func>
+std::vector<T> arrowValues(const AResultPrivate *d,
+                           int column,
+                           int first,
+                           int rows,
+                           std::vector<quint64> &nulls,
+                           Func toValue)
+{
+    std::vector<T> values(rows);
+    for (int i = 0; i < rows; ++i) {
+        if (d->isNull(first + i, column)) {
+            nulls[i >> 6] |= quint64(1) << (i & 63);
+        } else {
+            values[i] = toValue(first + i);
+        }
+    }
+    return values;
+}
+
+template <typename T>
+void arrowColumnInto(const AResultPrivate *d,
+                     int column,
+                     int first,
+                     std::span<T> out,
+                     std::span<quint64> nulls)
+{
+    if (first == 0) {
+        d->columnInto(column, out, nulls);
+        return;
+    }
+
+    // columnInto() always starts at the first row, the following batches go value by value
+    for (size_t i = 0; i < out.size(); ++i) {
+        const int row = first + int(i);
+        const bool null = d->isNull(row, column);
+        detail::setNullBit(nulls, i, null);
+        if (null) {
+            out[i] = T{};
+        } else if constexpr (std::is_same_v<T, int>) {
+            out[i] = d->toInt(row, column);
+        } else if constexpr (std::is_same_v<T, qint64>) {
+            out[i] = d->toLongLong(row, column);
+        } else if constexpr (std::is_same_v<T, double>) {
+            out[i] = d->toDouble(row, column);
+        } else {
+            out[i] = d->toString(row, column);
+        }
+    }
+}
+
+void arrowBinaryColumn(ArrowBody &body,
+                       int rows,
+                       std::vector<quint64> &nulls,
+                       const std::function<QByteArray(int)> &toBytes)
+{
+    std::vector<qint32> offsets;
+    offsets.reserve(rows + 1);
+    offsets.push_back(0);
+
+    QByteArray data;
+    for (int i = 0; i < rows; ++i) {
+        if (!(nulls[i >> 6] & (quint64(1) << (i & 63)))) {
+            data.append(toBytes(i));
+        }
+        offsets.push_back(qint32(data.size()));
+    }
+
+    body.addNode(rows, body.addValidity(nulls, rows));
+    body.addBuffer(arrowBytes(offsets));
+    body.addBuffer(data);
+}
+
+void arrowBatchColumn(ArrowBody &body,
+                      const AResultPrivate *d,
+                      const ArrowColumn &arrow,
+                      int column,
+                      int first,
+                      int rows)
+{
+    std::vector<quint64> nulls((rows + 63) / 64, 0);
+    switch (arrow.type) {
+    case ArrowNull:
+        body.addNode(rows, rows);
+        break;
+    case ArrowBool:
+    {
+        QByteArray bits((rows + 7) / 8, '\0');
+        for (int i = 0; i < rows; ++i) {
+            if (d->isNull(first + i, column)) {
+                nulls[i >> 6] |= quint64(1) << (i & 63);
+            } else if (d->toBool(first + i, column)) {
+                bits[i >> 3] = char(bits[i >> 3] | (1 << (i & 7)));
+            }
+        }
+        body.addNode(rows, body.addValidity(nulls, rows));
+        body.addBuffer(bits);
+        break;
+    }
+    case ArrowInt:
+        if (arrow.bitWidth == 32) {
+            std::vector<int> values(rows);
+            arrowColumnInto(d, column, first, std::span<int>(values), nulls);
+            body.addNode(rows, body.addValidity(nulls, rows));
+            body.addBuffer(arrowBytes(values));
+        } else if (arrow.isSigned) {
+            std::vector<qint64> values(rows);
+            arrowColumnInto(d, column, first, std::span<qint64>(values), nulls);
+            body.addNode(rows, body.addValidity(nulls, rows));
+            body.addBuffer(arrowBytes(values));
+        } else {
+            const auto values = arrowValues<quint64>(d, column, first, rows, nulls, [&](int row) {
+                return d->toULongLong(row, column);
+            });
+            body.addNode(rows, body.addValidity(nulls, rows));
+            body.addBuffer(arrowBytes(values));
+        }
+        break;
+    case ArrowFloat:
+    {
+        std::vector<double> values(rows);
+        arrowColumnInto(d, column, first, std::span<double>(values), nulls);
+        body.addNode(rows, body.addValidity(nulls, rows));
+        body.addBuffer(arrowBytes(values));
+        break;
+    }
+    case ArrowDate:
+    {
+        // Days since the UNIX epoch
+        const auto values = arrowValues<qint32>(d, column, first, rows, nulls, [&](int row) {
+            return qint32(d->toDate(row, column).toJulianDay() - 2440588);
+        });
+        body.addNode(rows, body.addValidity(nulls, rows));
+        body.addBuffer(arrowBytes(values));
+        break;
+    }
+    case ArrowTime:
+    {
+        const auto values = arrowValues<qint32>(d, column, first, rows, nulls, [&](int row) {
+            return qint32(d->toTime(row, column).msecsSinceStartOfDay());
+        });
+        body.addNode(rows, body.addValidity(nulls, rows));
+        body.addBuffer(arrowBytes(values));
+        break;
+    }
+    case ArrowTimestamp:
+    {
+        const auto values = arrowValues<qint64>(d, column, first, rows, nulls, [&](int row) {
+            return d->toDateTime(row, column).toMSecsSinceEpoch();
+        });
+        body.addNode(rows, body.addValidity(nulls, rows));
+        body.addBuffer(arrowBytes(values));
+        break;
+    }
+    case ArrowBinary:
+        for (int i = 0; i < rows; ++i) {
+            if (d->isNull(first + i, column)) {
+                nulls[i >> 6] |= quint64(1) << (i & 63);
+            }
+        }
+        arrowBinaryColumn(body, rows, nulls, [&](int i) {
+            return d->toByteArray(first + i, column);
+        });
+        break;
+    case ArrowUtf8:
+    {
+        std::vector<QString> values(rows);
+        arrowColumnInto(d, column, first, std::span<QString>(values), nulls);
+        arrowBinaryColumn(body, rows, nulls, [&values](int i) { return values[i].toUtf8(); });
+        break;
+    }
+    }
+}
+
+QByteArray arrowRecordBatch(const ArrowBody &body, int rows)
+{
+    FlatBufferBuilder fbb;
+    const quint32 buffers = fbb.createPairVector(body.buffers);
+    const quint32 nodes   = fbb.createPairVector(body.nodes);
+
+    fbb.startTable();
+    fbb.addScalar(0, qint64(rows));
+    fbb.addOffset(1, nodes);
+    fbb.addOffset(2, buffers);
+    const quint32 batch = fbb.endTable();
+
+    return arrowMessage(fbb, ArrowRecordBatch, batch, body.body.size());
+}
+
+// Writes an encapsulated message: continuation marker, metadata size, metadata and body
+bool writeArrowMessage(QIODevice *device, const QByteArray &metadata, const QByteArray &body = {})
+{
+    const qsizetype padding = (8 - metadata.size() % 8) % 8;
+    const quint32 marker    = 0xFFFFFFFF;
+    const qint32 size       = qToLittleEndian(qint32(metadata.size() + padding));
+
+    QByteArray header;
+    header.append(reinterpret_cast<const char *>(&marker), sizeof(marker));
+    header.append(reinterpret_cast<const char *>(&size), sizeof(size));
+    header.append(metadata);
+    header.append(QByteArray(padding, '\0'));
+
+    return device->write(header) == header.size() && device->write(body) == body.size();
+}
+
+} // namespace
+
+bool AResult::writeArrowIpc(QIODevice *device) const
+{
+    if (hasError()) {
+        return false;
+    }
+
+    std::vector<ArrowColumn> columns;
+    columns.reserve(fields());
+    for (int column = 0; column < fields(); ++column) {
+        columns.push_back(arrowColumn(d.get(), column));
+    }
+
+    if (!writeArrowMessage(device, arrowSchema(columns))) {
+        return false;
+    }
+
+    const int rows = size();
+    for (int first = 0; first < rows; first += arrowBatchRows) {
+        const int batchRows = std::min(arrowBatchRows, rows - first);
+
+        ArrowBody body;
+        for (size_t column = 0; column < columns.size(); ++column) {
+            arrowBatchColumn(body, d.get(), columns[column], int(column), first, batchRows);
+        }
+
+        if (!writeArrowMessage(device, arrowRecordBatch(body, batchRows), body.body)) {
+            return false;
+        }
+    }
+
+    // End of stream
+    const QByteArray eos("\xFF\xFF\xFF\xFF\x00\x00\x00\x00", 8);
+    return device->write(eos) == eos.size();
+}
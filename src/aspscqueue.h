@@ -0,0 +1,114 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2025 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <optional>
+
+#include <QtGlobal>
+
+namespace ASql {
+
+/*!
+ * \brief ASpscQueue is a lock-free queue with a single producer and a single consumer thread
+ *
+ * Items are stored in fixed size blocks linked together, so the producer never waits
+ * for the consumer. push() tells the producer when the consumer has to be woken up,
+ * which only happens once until the consumer calls wakeupReceived(), coalescing
+ * the wake-ups of items that complete together.
+ */
+template <typename T, qsizetype BlockSize = 128>
+class ASpscQueue
+{
+public:
+    ASpscQueue()
+        : m_head{new Block}
+        , m_tail{m_head}
+    {
+    }
+
+    ~ASpscQueue()
+    {
+        while (pop()) {
+        }
+        delete m_head;
+    }
+
+    Q_DISABLE_COPY_MOVE(ASpscQueue)
+
+    /*!
+     * \brief push appends an item, called from the producer thread only
+     * \return true if the consumer must be woken up
+     */
+    bool push(T value)
+    {
+        qsizetype index = m_tail->written.load(std::memory_order_relaxed);
+        if (index == BlockSize) {
+            auto block = new Block;
+            m_tail->next.store(block, std::memory_order_release);
+            m_tail = block;
+            index  = 0;
+        }
+
+        m_tail->items[index].emplace(std::move(value));
+        m_tail->written.store(index + 1, std::memory_order_release);
+
+        return !m_wakeupPending.exchange(true);
+    }
+
+    /*!
+     * \brief wakeupReceived must be called by the consumer before draining the queue
+     */
+    void wakeupReceived()
+    {
+        // An exchange synchronizes with the push() that set the flag
+        m_wakeupPending.exchange(false);
+    }
+
+    /*!
+     * \brief pop takes the oldest item, called from the consumer thread only
+     */
+    std::optional<T> pop()
+    {
+        while (true) {
+            if (m_headIndex < m_head->written.load(std::memory_order_acquire)) {
+                std::optional<T> ret = std::move(m_head->items[m_headIndex]);
+                m_head->items[m_headIndex++].reset();
+                return ret;
+            }
+
+            if (m_headIndex < BlockSize) {
+                return {};
+            }
+
+            Block *next = m_head->next.load(std::memory_order_acquire);
+            if (!next) {
+                return {};
+            }
+            delete m_head;
+            m_head      = next;
+            m_headIndex = 0;
+        }
+    }
+
+private:
+    struct Block {
+        std::array<std::optional<T>, BlockSize> items;
+        std::atomic<qsizetype> written = 0;
+        std::atomic<Block *> next      = nullptr;
+    };
+
+    // Consumer side
+    alignas(64) Block *m_head;
+    qsizetype m_headIndex = 0;
+
+    // Producer side
+    alignas(64) Block *m_tail;
+
+    alignas(64) std::atomic_bool m_wakeupPending = false;
+};
+
+} // namespace ASql
@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2025 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+#include "astrand.h"
+
+#include <deque>
+
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+namespace ASql {
+
+class AStrandPrivate
+{
+public:
+    static void run(const std::shared_ptr<AStrandPrivate> &d);
+
+    QMutex mutex;
+    QWaitCondition idle;
+    std::deque<std::function<void()>> tasks;
+    QThreadPool *pool;
+    bool running = false;
+};
+
+} // namespace ASql
+
+using namespace ASql;
+
+namespace {
+// Tasks run before giving the worker thread back to other strands
+constexpr int StrandBatchSize = 16;
+} // namespace
+
+void AStrandPrivate::run(const std::shared_ptr<AStrandPrivate> &d)
+{
+    for (int i = 0; i < StrandBatchSize; ++i) {
+        std::function<void()> task;
+        {
+            QMutexLocker _(&d->mutex);
+            if (d->tasks.empty()) {
+                d->running = false;
+                d->idle.wakeAll();
+                return;
+            }
+            task = std::move(d->tasks.front());
+            d->tasks.pop_front();
+        }
+        task();
+    }
+
+    d->pool->start([d] { run(d); });
+}
+
+AStrand::AStrand(QThreadPool *pool)
+    : d(std::make_shared<AStrandPrivate>())
+{
+    d->pool = pool;
+}
+
+AStrand::~AStrand()
+{
+    std::deque<std::function<void()>> dropped;
+
+    QMutexLocker _(&d->mutex);
+    dropped.swap(d->tasks);
+    while (d->running) {
+        d->idle.wait(&d->mutex);
+    }
+}
+
+void AStrand::post(std::function<void()> task)
+{
+    {
+        QMutexLocker _(&d->mutex);
+        d->tasks.emplace_back(std::move(task));
+        if (d->running) {
+            return;
+        }
+        d->running = true;
+    }
+
+    d->pool->start([d = d] { AStrandPrivate::run(d); });
+}
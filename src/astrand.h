@@ -0,0 +1,43 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2025 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <asql_export.h>
+#include <functional>
+#include <memory>
+
+class QThreadPool;
+
+namespace ASql {
+
+class AStrandPrivate;
+
+/*!
+ * \brief AStrand is a serial task queue that runs on a shared QThreadPool
+ *
+ * Tasks posted to the same strand run one at a time and in order, but not
+ * always on the same thread, which allows drivers with blocking APIs to
+ * multiplex many connections onto a bounded number of threads.
+ */
+class ASQL_EXPORT AStrand
+{
+public:
+    AStrand(QThreadPool *pool);
+
+    /*!
+     * \brief ~AStrand drops the tasks not yet started and waits for the running one
+     */
+    ~AStrand();
+
+    /*!
+     * \brief post enqueues a \p task to run after all previously posted ones
+     */
+    void post(std::function<void()> task);
+
+private:
+    std::shared_ptr<AStrandPrivate> d;
+};
+
+} // namespace ASql
@@ -0,0 +1,178 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2025 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "apgparsers.h"
+
+#include <QObject>
+#include <QTest>
+
+using namespace ASql;
+using namespace Qt::Literals::StringLiterals;
+
+/*!
+ * Compares the PostgreSQL text parsers with the QString and Qt::ISODate path
+ * AResultPg used before, run with -tickcounter or -callgrind for stable numbers.
+ */
+class BenchPgParsers : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void dateTime_data();
+    void dateTime();
+    void dateTimeIsoDate_data();
+    void dateTimeIsoDate();
+
+    void date();
+    void dateIsoDate();
+    void time();
+    void timeIsoDate();
+    void uuid();
+    void uuidFromString();
+
+    void fallback();
+};
+
+namespace {
+
+// The conversion AResultPg::toDateTime() used to do
+QDateTime isoDateTime(const char *val)
+{
+    QString dtval = QString::fromLatin1(val);
+    if (dtval.length() < 10) {
+        return {};
+    }
+
+    const QChar sign = dtval[dtval.size() - 3];
+    if (sign == u'-' || sign == u'+') {
+        dtval += u":00";
+    }
+    return QDateTime::fromString(dtval, Qt::ISODate);
+}
+
+void addDateTimeRows()
+{
+    QTest::addColumn<QByteArray>("text");
+
+    QTest::newRow("timestamp") << "2024-02-29 13:45:07"_ba;
+    QTest::newRow("timestamp msecs") << "2024-02-29 13:45:07.123"_ba;
+    QTest::newRow("timestamp usecs") << "2024-02-29 13:45:07.123456"_ba;
+    QTest::newRow("timestamptz") << "2024-02-29 13:45:07.5+02"_ba;
+    QTest::newRow("timestamptz minutes") << "1999-12-31 23:59:59.001-03:30"_ba;
+}
+
+} // namespace
+
+void BenchPgParsers::dateTime_data()
+{
+    addDateTimeRows();
+}
+
+void BenchPgParsers::dateTime()
+{
+    QFETCH(QByteArray, text);
+
+    const QDateTime expected = isoDateTime(text.constData());
+    QVERIFY(expected.isValid());
+    QCOMPARE(detail::pgDateTime(text), expected);
+    QCOMPARE(detail::pgDateTime(text).offsetFromUtc(), expected.offsetFromUtc());
+
+    QDateTime ret;
+    QBENCHMARK {
+        ret = detail::pgDateTime(text);
+    }
+}
+
+void BenchPgParsers::dateTimeIsoDate_data()
+{
+    addDateTimeRows();
+}
+
+void BenchPgParsers::dateTimeIsoDate()
+{
+    QFETCH(QByteArray, text);
+
+    QDateTime ret;
+    QBENCHMARK {
+        ret = isoDateTime(text.constData());
+    }
+}
+
+void BenchPgParsers::date()
+{
+    const auto text = "2024-02-29"_ba;
+    QCOMPARE(detail::pgDate(text), QDate(2024, 2, 29));
+
+    QDate ret;
+    QBENCHMARK {
+        ret = detail::pgDate(text);
+    }
+}
+
+void BenchPgParsers::dateIsoDate()
+{
+    const auto text = "2024-02-29"_ba;
+
+    QDate ret;
+    QBENCHMARK {
+        ret = QDate::fromString(QString::fromLatin1(text), Qt::ISODate);
+    }
+}
+
+void BenchPgParsers::time()
+{
+    const auto text = "13:45:07.25"_ba;
+    QCOMPARE(detail::pgTime(text), QTime(13, 45, 7, 250));
+
+    QTime ret;
+    QBENCHMARK {
+        ret = detail::pgTime(text);
+    }
+}
+
+void BenchPgParsers::timeIsoDate()
+{
+    const auto text = "13:45:07.25"_ba;
+
+    QTime ret;
+    QBENCHMARK {
+        ret = QTime::fromString(QString::fromLatin1(text), Qt::ISODate);
+    }
+}
+
+void BenchPgParsers::uuid()
+{
+    const auto text = "a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11"_ba;
+    QCOMPARE(detail::pgUuid(text), QUuid::fromString(text.constData()));
+
+    QUuid ret;
+    QBENCHMARK {
+        ret = detail::pgUuid(text);
+    }
+}
+
+void BenchPgParsers::uuidFromString()
+{
+    const auto text = "a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11"_ba;
+
+    QUuid ret;
+    QBENCHMARK {
+        ret = QUuid::fromString(text.constData());
+    }
+}
+
+void BenchPgParsers::fallback()
+{
+    // Values outside of the fixed format still go through Qt::ISODate
+    QVERIFY(!detail::pgFastDate("infinity"_ba));
+    QVERIFY(!detail::pgFastDateTime("2024-02-29 13:45:07 BC"_ba));
+    QVERIFY(!detail::pgFastTime("24:00:00"_ba));
+    QVERIFY(!detail::pgFastUuid("{a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11}"_ba));
+    QCOMPARE(detail::pgUuid("{a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11}"_ba),
+             QUuid::fromString(u"a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11"));
+    QCOMPARE(detail::pgDate(""_ba), QDate());
+}
+
+QTEST_MAIN(BenchPgParsers)
+#include "bench_PgParsers.moc"
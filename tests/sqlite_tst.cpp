@@ -3,19 +3,47 @@
 
 #include "ASqlite.hpp"
 #include "CoverageObject.hpp"
+#include "acache.h"
 #include "acoroexpected.h"
 #include "adatabase.h"
 #include "apool.h"
 #include "apreparedquery.h"
 
+#include <QBuffer>
+#include <QCborArray>
+#include <QCborMap>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
 #include <QJsonObject>
 #include <QObject>
 #include <QStandardPaths>
+#include <QTemporaryDir>
 #include <QTest>
+#include <QThreadPool>
+#include <QTimer>
 #include <QUrl>
 
 using namespace ASql;
 using namespace Qt::Literals::StringLiterals;
+using namespace std::chrono_literals;
+
+struct Person {
+    qint64 id = 0;
+    QString name;
+    std::optional<double> score;
+    QByteArray avatar;
+};
+
+template <>
+struct ASql::ARowMapping<Person> {
+    static constexpr std::tuple fields{
+        ABind(&Person::id, 0),
+        ABind(&Person::name, u"name"),
+        ABind(&Person::score, u"score"),
+        ABind(&Person::avatar, u"avatar"),
+    };
+};
 
 class TestSqlite : public CoverageObject
 {
@@ -30,6 +58,24 @@ private Q_SLOTS:
     void testPoolBeginRollback();
     void testDatabaseBeginCommit();
     void testDatabaseBeginRollback();
+    void testCacheSnapshot();
+    void testCacheStatistics();
+    void testCacheTimeToLive();
+    void testCacheCompactResults();
+    void testCachePolicy();
+    void testResultToVector();
+    void testResultWriteJson();
+    void testResultWriteCbor();
+    void testResultJsonParallel();
+    void testResultArrowIpc();
+    void testStatementCache();
+    void testWalReaders();
+    void testWalTransactions();
+    void testThreadPool();
+    void testSingleRowMode();
+    void testExecBatch();
+    void testQueryCancellation();
+    void testBusyTimeout();
 };
 
 void TestSqlite::initTest()
@@ -180,6 +226,22 @@ void TestSqlite::testQueries()
 
             ACOMPARE_EQ((*result)[0][0].toString(), u"a"_s);
             ACOMPARE_EQ((*result)[0][1].toInt(), 1);
+
+            const AColumnRef a = result->columnRef(u"a");
+            AVERIFY(a.isValid());
+            ACOMPARE_EQ(a.index(), 0);
+            ACOMPARE_EQ((*result)[0][a].toString(), u"a"_s);
+            ACOMPARE_EQ(result->indexOfField(u"1"_s), 1);
+            ACOMPARE_EQ((*result)[0]["1"_L1].toInt(), 1);
+            AVERIFY(!result->columnRef("missing"_L1).isValid());
+
+            std::vector<quint64> nulls;
+            const auto ints = result->column<qint64>(1, &nulls);
+            ACOMPARE_EQ(ints.size(), 1u);
+            ACOMPARE_EQ(ints[0], 1);
+            ACOMPARE_EQ(nulls.size(), 1u);
+            ACOMPARE_EQ(nulls[0], 0u);
+            ACOMPARE_EQ(result->column<QString>(0).at(0), u"a"_s);
         };
         singleQuery(finished);
 
@@ -465,6 +527,1030 @@ void TestSqlite::testDatabaseBeginRollback()
     loop.exec();
 }
 
+void TestSqlite::testCacheSnapshot()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(u"cache.snapshot"_s);
+
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto cacheSnapshot = [](std::shared_ptr<QObject> finished,
+                                QString fileName) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "cacheSnapshot exited" << finished.use_count(); });
+
+            ACache cache;
+            cache.setDatabasePool(APool::defaultPool.toString());
+
+            auto result = co_await cache.exec(u"SELECT 'a' a, 1 b, ? c"_s, {u"foo"_s});
+            AVERIFY(result);
+            AVERIFY(co_await cache.exec(u"SELECT 1 WHERE 0"_s));
+            AVERIFY(cache.saveSnapshot(fileName));
+
+            ACache restored;
+            ACOMPARE_EQ(restored.loadSnapshot(fileName, 1h), 2);
+            ACOMPARE_EQ(restored.loadSnapshot(fileName), 0);
+            ACOMPARE_EQ(restored.size(), 2);
+
+            // An empty result has no cells, the entry saved after it must still load
+            auto empty = co_await restored.exec(u"SELECT 1 WHERE 0"_s);
+            AVERIFY(empty);
+            ACOMPARE_EQ(empty->size(), 0);
+
+            // Served from the snapshot, no database was set
+            auto cached = co_await restored.exec(u"SELECT 'a' a, 1 b, ? c"_s, {u"foo"_s});
+            AVERIFY(cached);
+            ACOMPARE_EQ(cached->size(), 1);
+            ACOMPARE_EQ(cached->columnNames(), result->columnNames());
+            ACOMPARE_EQ((*cached)[0][0].toString(), u"a"_s);
+            ACOMPARE_EQ((*cached)[0][1].toInt(), 1);
+            ACOMPARE_EQ((*cached)[0][u"c"_s].toString(), u"foo"_s);
+
+            ACache all;
+            ACOMPARE_EQ(all.loadSnapshot(fileName, -1ms), 2);
+            ACOMPARE_EQ(all.loadSnapshot(u"/nonexistent/cache.snapshot"_s), -1);
+        };
+        cacheSnapshot(finished, fileName);
+    }
+    loop.exec();
+
+    // Entries keep their own time to live instead of getting the default one
+    ACache restored;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto cacheSnapshotTtl = [](std::shared_ptr<QObject> finished,
+                                   QString fileName,
+                                   ACache *restored) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "cacheSnapshotTtl exited" << finished.use_count(); });
+
+            ACache cache;
+            cache.setDatabasePool(APool::defaultPool.toString());
+            cache.setDefaultTimeToLive(1h);
+            cache.setPolicy({.emptyTtl = 300ms});
+
+            AVERIFY(co_await cache.exec(u"SELECT 1 WHERE 1 = ?"_s, {2}));
+            AVERIFY(co_await cache.execTtl(u"SELECT 2"_s, 1h));
+            AVERIFY(co_await cache.exec(u"SELECT 3"_s));
+            AVERIFY(cache.saveSnapshot(fileName));
+
+            ACOMPARE_EQ(restored->loadSnapshot(fileName), 3);
+        };
+        cacheSnapshotTtl(finished, fileName, &restored);
+    }
+    loop.exec();
+
+    QTRY_COMPARE(restored.size(), 2);
+    QCOMPARE(restored.statistics().total.expirations, 1u);
+}
+
+void TestSqlite::testCacheStatistics()
+{
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto cacheStatistics = [](std::shared_ptr<QObject> finished) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "cacheStatistics exited" << finished.use_count(); });
+
+            ACache cache;
+            cache.setDatabasePool(APool::defaultPool.toString());
+
+            const QString query = u"SELECT ?"_s;
+            auto first          = cache.exec(query, {1});
+            auto coalesced      = cache.exec(query, {1});
+            AVERIFY(co_await first);
+            AVERIFY(co_await coalesced);
+            AVERIFY(co_await cache.exec(query, {1}));
+            AVERIFY(co_await cache.exec(query, {2}));
+            AVERIFY(cache.clear(query, {2}));
+
+            const ACacheStatistics stats = cache.statistics();
+            ACOMPARE_EQ(stats.size, 1);
+            ACOMPARE_EQ(stats.total.misses, 2u);
+            ACOMPARE_EQ(stats.total.coalesced, 1u);
+            ACOMPARE_EQ(stats.total.hits, 1u);
+            ACOMPARE_EQ(stats.total.evictions, 1u);
+            ACOMPARE_EQ(stats.total.fetches, 2u);
+            ACOMPARE_EQ(stats.total.fetchErrors, 0u);
+            ACOMPARE_EQ(stats.queries.size(), 1);
+            ACOMPARE_EQ(stats.queries.value(query).misses, 2u);
+
+            cache.resetStatistics();
+            ACOMPARE_EQ(cache.statistics().total.misses, 0u);
+
+            // Queries past the limit share a single set of counters
+            cache.setMaxStatisticsQueries(2);
+            for (int i = 0; i < 4; ++i) {
+                AVERIFY(co_await cache.exec(u"SELECT %1"_s.arg(i)));
+            }
+
+            const ACacheStatistics limited = cache.statistics();
+            ACOMPARE_EQ(limited.total.misses, 4u);
+            ACOMPARE_EQ(limited.queries.size(), 2);
+            ACOMPARE_EQ(limited.otherQueries.misses, 2u);
+        };
+        cacheStatistics(finished);
+    }
+    loop.exec();
+}
+
+void TestSqlite::testCacheTimeToLive()
+{
+    ACache cache;
+    cache.setDatabasePool(APool::defaultPool.toString());
+
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto cacheTimeToLive = [](std::shared_ptr<QObject> finished,
+                                  ACache *cache) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "cacheTimeToLive exited" << finished.use_count(); });
+
+            AVERIFY(co_await cache->execTtl(u"SELECT 1"_s, 200ms));
+            AVERIFY(co_await cache->exec(u"SELECT 2"_s));
+            ACOMPARE_EQ(cache->size(), 2);
+        };
+        cacheTimeToLive(finished, &cache);
+    }
+    loop.exec();
+
+    QTRY_COMPARE(cache.size(), 1);
+    QCOMPARE(cache.statistics().total.expirations, 1u);
+}
+
+void TestSqlite::testCacheCompactResults()
+{
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto cacheCompact = [](std::shared_ptr<QObject> finished) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "cacheCompact exited" << finished.use_count(); });
+
+            ACache cache;
+            cache.setDatabasePool(APool::defaultPool.toString());
+            cache.setCompactResults(true);
+
+            const QString query = u"SELECT 1 i, 2.5 d, 'foo' s, NULL n, x'0102' b UNION ALL "
+                                  u"SELECT NULL, 3.5, NULL, NULL, x''"_s;
+            auto fetched = co_await cache.exec(query);
+            AVERIFY(fetched);
+
+            auto cached = co_await cache.exec(query);
+            AVERIFY(cached);
+            ACOMPARE_EQ(cached->size(), 2);
+            ACOMPARE_EQ(cached->columnNames(), fetched->columnNames());
+            for (int row = 0; row < fetched->size(); ++row) {
+                for (int column = 0; column < fetched->fields(); ++column) {
+                    ACOMPARE_EQ((*cached)[row][column].isNull(),
+                                (*fetched)[row][column].isNull());
+                    ACOMPARE_EQ((*cached)[row][column].toString(),
+                                (*fetched)[row][column].toString());
+                }
+            }
+            ACOMPARE_EQ((*cached)[0][u"i"_s].toInt(), 1);
+            ACOMPARE_EQ((*cached)[1][u"d"_s].toDouble(), 3.5);
+            ACOMPARE_EQ((*cached)[0][u"b"_s].toByteArray(), "\x01\x02"_ba);
+
+            // CBOR values come from the typed cells
+            ACOMPARE_EQ((*cached)[0][u"i"_s].toCborValue(), QCborValue(1));
+            ACOMPARE_EQ((*cached)[0][u"s"_s].toCborValue(), QCborValue(u"foo"_s));
+            ACOMPARE_EQ((*cached)[1][u"d"_s].toCborValue(), QCborValue(3.5));
+        };
+        cacheCompact(finished);
+    }
+    loop.exec();
+}
+
+void TestSqlite::testCachePolicy()
+{
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto cachePolicy = [](std::shared_ptr<QObject> finished) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "cachePolicy exited" << finished.use_count(); });
+
+            ACache cache;
+            cache.setDatabasePool(APool::defaultPool.toString());
+            cache.setPolicy({
+                .emptyTtl    = 0ms,
+                .cacheErrors = false,
+                .retries     = 2,
+                .retryDelay  = 10ms,
+            });
+
+            auto failed = co_await cache.exec(u"SELECT * FROM no_such_table"_s);
+            AVERIFY(!failed);
+            AVERIFY(!failed.error().isEmpty());
+            ACOMPARE_EQ(cache.size(), 0);
+            ACOMPARE_EQ(cache.statistics().total.retries, 2u);
+            ACOMPARE_EQ(cache.statistics().total.fetchErrors, 3u);
+
+            auto empty = co_await cache.exec(u"SELECT 1 WHERE 1 = 0"_s);
+            AVERIFY(empty);
+            ACOMPARE_EQ(empty->size(), 0);
+
+            // Empty results expire right away
+            auto again = co_await cache.exec(u"SELECT 1 WHERE 1 = 0"_s);
+            AVERIFY(again);
+            ACOMPARE_EQ(cache.statistics().total.hits, 0u);
+            ACOMPARE_EQ(cache.statistics().total.fetches, 5u);
+        };
+        cachePolicy(finished);
+    }
+    loop.exec();
+}
+
+void TestSqlite::testResultToVector()
+{
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto toVector = [](std::shared_ptr<QObject> finished) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "toVector exited" << finished.use_count(); });
+
+            auto result =
+                co_await APool::exec(u"SELECT 1 id, 'foo' name, 2.5 score, x'01' avatar UNION ALL "
+                                     u"SELECT 2, 'bar', NULL, x''"_s);
+            AVERIFY(result);
+
+            const std::vector<Person> people = result->toVector<Person>();
+            ACOMPARE_EQ(people.size(), 2u);
+            ACOMPARE_EQ(people[0].id, 1);
+            ACOMPARE_EQ(people[0].name, u"foo"_s);
+            ACOMPARE_EQ(people[0].score.value_or(0), 2.5);
+            ACOMPARE_EQ(people[0].avatar, "\x01"_ba);
+            ACOMPARE_EQ(people[1].id, 2);
+            ACOMPARE_EQ(people[1].name, u"bar"_s);
+            AVERIFY(!people[1].score.has_value());
+        };
+        toVector(finished);
+    }
+    loop.exec();
+}
+
+void TestSqlite::testResultWriteJson()
+{
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto writeJson = [](std::shared_ptr<QObject> finished) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "writeJson exited" << finished.use_count(); });
+
+            auto result = co_await APool::exec(
+                u"SELECT 1 id, 'a \"quoted\"\n\\ name' name, 2.5 score, NULL nothing UNION ALL "
+                u"SELECT 2, 'ação €', NULL, NULL"_s);
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[1][1].toString(), u"ação €"_s);
+            ACOMPARE_EQ((*result)[1][1].toStdString(), std::string("ação €"));
+            ACOMPARE_EQ((*result)[1][1].toByteArray(), u"ação €"_s.toUtf8());
+
+            QByteArray json;
+            result->writeJson(json, AResult::Layout::ArrayObject);
+            ACOMPARE_EQ(QJsonDocument::fromJson(json).array(), result->toJsonArrayObject());
+
+            json.clear();
+            result->writeJson(json, AResult::Layout::ObjectArray);
+            ACOMPARE_EQ(QJsonDocument::fromJson(json).object(), result->toJsonObjectArray());
+
+            json.clear();
+            result->writeJson(json, AResult::Layout::ObjectIndexed);
+            ACOMPARE_EQ(QJsonDocument::fromJson(json).object(), result->toJsonObjectIndexed());
+
+            json.clear();
+            result->writeJson(json, AResult::Layout::Flattened);
+            ACOMPARE_EQ(QJsonDocument::fromJson(json).object(), result->toJsonFlattened());
+        };
+        writeJson(finished);
+    }
+    loop.exec();
+}
+
+void TestSqlite::testResultWriteCbor()
+{
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto writeCbor = [](std::shared_ptr<QObject> finished) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "writeCbor exited" << finished.use_count(); });
+
+            auto result = co_await APool::exec(u"SELECT 1 id, 'foo' name, 2.5 score, x'0102' data "
+                                               u"UNION ALL SELECT 2, 'bar', -1.5, x''"_s);
+            AVERIFY(result);
+
+            QByteArray cbor;
+            result->writeCbor(cbor, AResult::Layout::ArrayObject);
+            ACOMPARE_EQ(QCborValue::fromCbor(cbor).toArray(), result->toCborArrayMap());
+
+            cbor.clear();
+            result->writeCbor(cbor, AResult::Layout::ObjectArray);
+            ACOMPARE_EQ(QCborValue::fromCbor(cbor).toMap(), result->toCborMapArray());
+
+            cbor.clear();
+            result->writeCbor(cbor, AResult::Layout::ObjectIndexed);
+            ACOMPARE_EQ(QCborValue::fromCbor(cbor).toMap(), result->toCborMapIndexed());
+
+            cbor.clear();
+            result->writeCbor(cbor, AResult::Layout::Flattened);
+            ACOMPARE_EQ(QCborValue::fromCbor(cbor).toMap(), result->toCborFlattened());
+
+            auto nulls = co_await APool::exec(u"SELECT NULL"_s);
+            AVERIFY(nulls);
+            cbor.clear();
+            nulls->writeCbor(cbor, AResult::Layout::Flattened);
+            AVERIFY(QCborValue::fromCbor(cbor).toMap()[u"data"_s].toArray().at(0).isNull());
+        };
+        writeCbor(finished);
+    }
+    loop.exec();
+}
+
+void TestSqlite::testResultJsonParallel()
+{
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto jsonParallel = [](std::shared_ptr<QObject> finished) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "jsonParallel exited" << finished.use_count(); });
+
+            auto result = co_await APool::exec(
+                u"WITH RECURSIVE cnt(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM cnt "
+                u"WHERE x < 5000) SELECT x, 'row ' || x name, x / 3.0 ratio FROM cnt"_s);
+            AVERIFY(result);
+            ACOMPARE_EQ(result->size(), 5000);
+
+            for (auto layout : {AResult::Layout::ArrayObject,
+                                AResult::Layout::ObjectArray,
+                                AResult::Layout::ObjectIndexed,
+                                AResult::Layout::Flattened}) {
+                QByteArray expected;
+                result->writeJson(expected, layout);
+
+                QByteArray parallel;
+                result->writeJsonParallel(parallel, layout);
+                ACOMPARE_EQ(parallel, expected);
+
+                auto async = co_await result->toJsonAsync(layout);
+                AVERIFY(async);
+                ACOMPARE_EQ(*async, expected);
+            }
+
+            auto empty = co_await APool::exec(u"SELECT 1 WHERE 1 = 0"_s);
+            AVERIFY(empty);
+            auto async = co_await empty->toJsonAsync();
+            AVERIFY(async);
+            ACOMPARE_EQ(*async, "[]"_ba);
+        };
+        jsonParallel(finished);
+    }
+    loop.exec();
+}
+
+void TestSqlite::testResultArrowIpc()
+{
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto arrowIpc = [](std::shared_ptr<QObject> finished) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "arrowIpc exited" << finished.use_count(); });
+
+            auto result = co_await APool::exec(u"SELECT 1 id, 'foo' name, 2.5 score UNION ALL "
+                                               u"SELECT NULL, NULL, 3.5"_s);
+            AVERIFY(result);
+
+            QBuffer buffer;
+            buffer.open(QIODevice::WriteOnly);
+            AVERIFY(result->writeArrowIpc(&buffer));
+
+            const QByteArray stream = buffer.data();
+            const QByteArray marker("\xFF\xFF\xFF\xFF", 4);
+            AVERIFY(stream.startsWith(marker));
+            AVERIFY(stream.endsWith(marker + QByteArray(4, '\0')));
+            ACOMPARE_EQ(stream.size() % 8, 0);
+            AVERIFY(stream.contains("name"_ba));
+            AVERIFY(stream.contains("foo"_ba));
+        };
+        arrowIpc(finished);
+    }
+    loop.exec();
+}
+
+void TestSqlite::testStatementCache()
+{
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto statementCache = [](std::shared_ptr<QObject> finished) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "statementCache exited" << finished.use_count(); });
+
+            ADatabase db{ASqlite::factory(u"sqlite://?MEMORY&STATEMENT_CACHE=2"_s)};
+            auto opened = co_await db.coOpen();
+            AVERIFY(opened);
+
+            auto result = co_await db.exec(u"CREATE TABLE cache (id INTEGER, name TEXT)"_s);
+            AVERIFY(result);
+
+            // Reusing the cached statement must not leak the previous bindings
+            for (int i = 0; i < 5; ++i) {
+                result = co_await db.exec(u"INSERT INTO cache VALUES (?, ?)"_s,
+                                          {i, i % 2 ? QVariant{} : QVariant{u"name"_s}});
+                AVERIFY(result);
+                ACOMPARE_EQ(result->numRowsAffected(), 1);
+            }
+
+            result = co_await db.exec(u"SELECT count(*) FROM cache WHERE name IS NULL"_s,
+                                      QVariantList{});
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 2);
+
+            // Evicts the INSERT statement from the cache
+            for (int i = 0; i < 3; ++i) {
+                result = co_await db.exec(u"SELECT name FROM cache WHERE id = ?"_s, {i});
+                AVERIFY(result);
+                ACOMPARE_EQ(result->size(), 1);
+                ACOMPARE_EQ((*result)[0][0].isNull(), i == 1);
+            }
+
+            // Parameters left unbound are NULL again
+            result = co_await db.exec(u"SELECT name FROM cache WHERE id = ?"_s, QVariantList{});
+            AVERIFY(result);
+            ACOMPARE_EQ(result->size(), 0);
+
+            result = co_await db.exec(u"SELECT name FROM cache WHERE id = ?"_s, QVariantList{0});
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toString(), u"name"_s);
+
+            // A constraint violation keeps the cached statement usable
+            result = co_await db.exec(u"CREATE TABLE unique_cache (id INTEGER PRIMARY KEY)"_s);
+            AVERIFY(result);
+
+            for (int i = 0; i < 3; ++i) {
+                result = co_await db.exec(u"INSERT INTO unique_cache VALUES (?)"_s, {1});
+                AVERIFY(i == 0 ? bool(result) : !result);
+            }
+
+            result = co_await db.exec(u"INSERT INTO unique_cache VALUES (?)"_s, {2});
+            AVERIFY(result);
+            ACOMPARE_EQ(result->numRowsAffected(), 1);
+        };
+        statementCache(finished);
+    }
+    loop.exec();
+}
+
+void TestSqlite::testWalReaders()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QUrl url = QUrl::fromLocalFile(dir.filePath(u"wal.db"_s));
+    url.setScheme(u"sqlite"_s);
+    url.setQuery(u"READERS=2"_s);
+
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto walReaders = [](std::shared_ptr<QObject> finished,
+                             std::shared_ptr<ADriverFactory> factory) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "walReaders exited" << finished.use_count(); });
+
+            ADatabase db{factory};
+            auto opened = co_await db.coOpen();
+            AVERIFY(opened);
+
+            ADatabase other{factory};
+            opened = co_await other.coOpen();
+            AVERIFY(opened);
+
+            auto result = co_await db.exec(u"PRAGMA journal_mode"_s);
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toString(), u"wal"_s);
+
+            result = co_await db.exec(u"CREATE TABLE wal (id INTEGER)"_s);
+            AVERIFY(result);
+
+            auto t = co_await db.begin();
+            AVERIFY(t);
+
+            result = co_await t->database().exec(u"INSERT INTO wal VALUES (?)"_s, {1});
+            AVERIFY(result);
+
+            // Readers only see committed data, the transaction sees its own changes
+            result = co_await other.exec(u"SELECT count(*) FROM wal"_s);
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 0);
+
+            result = co_await t->database().exec(u"SELECT count(*) FROM wal"_s);
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 1);
+
+            // Writes of other drivers wait for the transaction to finish
+            auto insert = other.exec(u"INSERT INTO wal VALUES (?)"_s, {2});
+
+            result = co_await t->commit();
+            AVERIFY(result);
+
+            result = co_await insert;
+            AVERIFY(result);
+            ACOMPARE_EQ(result->numRowsAffected(), 1);
+
+            result = co_await other.exec(u"SELECT count(*) FROM wal"_s);
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 2);
+        };
+        walReaders(finished, ASqlite::factory(url));
+    }
+    loop.exec();
+}
+
+void TestSqlite::testWalTransactions()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QUrl url = QUrl::fromLocalFile(dir.filePath(u"wal.db"_s));
+    url.setScheme(u"sqlite"_s);
+    url.setQuery(u"READERS=2"_s);
+
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto walTransactions = [](std::shared_ptr<QObject> finished,
+                                  std::shared_ptr<ADriverFactory> factory) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "walTransactions exited" << finished.use_count(); });
+
+            ADatabase db{factory};
+            auto opened = co_await db.coOpen();
+            AVERIFY(opened);
+
+            ADatabase other{factory};
+            opened = co_await other.coOpen();
+            AVERIFY(opened);
+
+            auto result = co_await db.exec(u"PRAGMA foreign_keys = ON"_s);
+            AVERIFY(result);
+
+            result = co_await db.exec(u"CREATE TABLE parent (id INTEGER PRIMARY KEY)"_s);
+            AVERIFY(result);
+
+            result = co_await db.exec(u"CREATE TABLE child (parent INTEGER REFERENCES "
+                                      u"parent (id) DEFERRABLE INITIALLY DEFERRED)"_s);
+            AVERIFY(result);
+
+            // Only releasing the outermost savepoint ends the transaction
+            result = co_await db.exec(u"SAVEPOINT outer_sp"_s);
+            AVERIFY(result);
+
+            result = co_await db.exec(u"SAVEPOINT inner_sp"_s);
+            AVERIFY(result);
+
+            result = co_await db.exec(u"INSERT INTO parent VALUES (?)"_s, {1});
+            AVERIFY(result);
+
+            auto insert = other.exec(u"INSERT INTO parent VALUES (?)"_s, {2});
+
+            result = co_await db.exec(u"RELEASE inner_sp"_s);
+            AVERIFY(result);
+
+            result = co_await other.exec(u"SELECT count(*) FROM parent"_s);
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 0);
+
+            result = co_await db.exec(u"RELEASE SAVEPOINT outer_sp"_s);
+            AVERIFY(result);
+
+            result = co_await insert;
+            AVERIFY(result);
+
+            result = co_await other.exec(u"SELECT count(*) FROM parent"_s);
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 2);
+
+            // A BEGIN that fails doesn't keep the writer locked
+            result = co_await db.exec(u"BEGIN NOTHING"_s);
+            AVERIFY(!result);
+
+            result = co_await other.exec(u"INSERT INTO parent VALUES (?)"_s, {3});
+            AVERIFY(result);
+
+            // A COMMIT that fails leaves the transaction open and the writer locked
+            result = co_await db.exec(u"BEGIN"_s);
+            AVERIFY(result);
+
+            result = co_await db.exec(u"INSERT INTO child VALUES (?)"_s, {99});
+            AVERIFY(result);
+
+            result = co_await db.exec(u"COMMIT"_s);
+            AVERIFY(!result);
+
+            auto blocked = other.exec(u"INSERT INTO parent VALUES (?)"_s, {4});
+
+            result = co_await db.exec(u"SELECT count(*) FROM child"_s);
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 1);
+
+            result = co_await db.exec(u"ROLLBACK"_s);
+            AVERIFY(result);
+
+            result = co_await blocked;
+            AVERIFY(result);
+
+            result = co_await other.exec(u"SELECT count(*) FROM parent"_s);
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 4);
+
+            result = co_await other.exec(u"SELECT count(*) FROM child"_s);
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 0);
+
+            // A transaction queued right after a COMMIT keeps the writer locked
+            auto firstBegin  = db.exec(u"BEGIN"_s);
+            auto firstInsert = db.exec(u"INSERT INTO parent VALUES (?)"_s, {5});
+            auto firstCommit = db.exec(u"COMMIT"_s);
+            auto secondBegin = db.exec(u"BEGIN"_s);
+            auto queued      = other.exec(u"INSERT INTO parent VALUES (?)"_s, {6});
+
+            AVERIFY(co_await firstBegin);
+            AVERIFY(co_await firstInsert);
+            AVERIFY(co_await firstCommit);
+            AVERIFY(co_await secondBegin);
+
+            result = co_await db.exec(u"INSERT INTO parent VALUES (?)"_s, {7});
+            AVERIFY(result);
+
+            result = co_await db.exec(u"ROLLBACK"_s);
+            AVERIFY(result);
+
+            // Only ran after the second transaction, so it was not rolled back with it
+            result = co_await queued;
+            AVERIFY(result);
+
+            result = co_await other.exec(u"SELECT count(*) FROM parent WHERE id > 4"_s);
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 2);
+
+            // A transaction rolled back by SQLite itself doesn't keep the writer locked
+            result = co_await db.exec(u"BEGIN"_s);
+            AVERIFY(result);
+
+            result = co_await db.exec(u"INSERT OR ROLLBACK INTO parent VALUES (?)"_s, {1});
+            AVERIFY(!result);
+
+            result = co_await db.exec(u"ROLLBACK"_s);
+            AVERIFY(!result);
+
+            result = co_await other.exec(u"INSERT INTO parent VALUES (?)"_s, {8});
+            AVERIFY(result);
+        };
+        walTransactions(finished, ASqlite::factory(url));
+    }
+    loop.exec();
+}
+
+void TestSqlite::testThreadPool()
+{
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(2);
+
+    auto factory = ASqlite::factory(u"sqlite://?MEMORY"_s);
+    factory->setThreadPool(&threadPool);
+
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto strands = [](std::shared_ptr<QObject> finished,
+                          std::shared_ptr<ADriverFactory> factory) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "strands exited" << finished.use_count(); });
+
+            // More connections than threads, each one keeps its queries in order
+            for (int i = 0; i < 4; ++i) {
+                ADatabase db{factory};
+                auto opened = co_await db.coOpen();
+                AVERIFY(opened);
+
+                auto create = db.exec(u"CREATE TABLE strand (id INTEGER)"_s);
+                auto insert = db.exec(u"INSERT INTO strand VALUES (?), (?)"_s, {i, i + 1});
+                auto select = db.exec(u"SELECT sum(id) FROM strand"_s);
+
+                auto result = co_await create;
+                AVERIFY(result);
+                result = co_await insert;
+                AVERIFY(result);
+                result = co_await select;
+                AVERIFY(result);
+                ACOMPARE_EQ((*result)[0][0].toInt(), i * 2 + 1);
+            }
+        };
+        strands(finished, factory);
+    }
+    loop.exec();
+}
+
+void TestSqlite::testSingleRowMode()
+{
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto singleRowMode = [](std::shared_ptr<QObject> finished) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "singleRowMode exited" << finished.use_count(); });
+
+            ADatabase db{ASqlite::factory(u"sqlite://?MEMORY&BATCH_ROWS=100"_s)};
+            auto opened = co_await db.coOpen();
+            AVERIFY(opened);
+
+            // Keeps the worker busy so the mode is set before the streamed query starts
+            auto busy      = db.exec(u"WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 "
+                                     u"FROM n WHERE i < 100000) SELECT count(*) FROM n"_s);
+            auto awaitable = db.execMulti(u"WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL "
+                                          u"SELECT i + 1 FROM n WHERE i < 1050) SELECT i FROM n"_s);
+            db.setLastQuerySingleRowMode();
+
+            auto result = co_await busy;
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 100000);
+
+            int batches = 0;
+            int rows    = 0;
+            bool last   = true;
+            do {
+                auto batch = co_await awaitable;
+                AVERIFY(batch);
+                ACOMPARE_EQ(batch->fields(), 1);
+                for (int i = 0; i < batch->size(); ++i) {
+                    ACOMPARE_EQ((*batch)[i][0].toInt(), ++rows);
+                }
+
+                last = batch->lastResultSet();
+                ++batches;
+            } while (!last);
+
+            ACOMPARE_EQ(rows, 1050);
+            ACOMPARE_EQ(batches, 11);
+
+            // Only the query the mode was set on is streamed
+            result = co_await db.exec(u"WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 "
+                                      u"FROM n WHERE i < 1050) SELECT i FROM n"_s);
+            AVERIFY(result);
+            ACOMPARE_EQ(result->size(), 1050);
+        };
+        singleRowMode(finished);
+    }
+    loop.exec();
+}
+
+void TestSqlite::testExecBatch()
+{
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto execBatch = [](std::shared_ptr<QObject> finished) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "execBatch exited" << finished.use_count(); });
+
+            ADatabase db{ASqlite::factory(u"sqlite://?MEMORY"_s)};
+            auto opened = co_await db.coOpen();
+            AVERIFY(opened);
+
+            auto result =
+                co_await db.exec(u"CREATE TABLE batch (id INTEGER PRIMARY KEY, name TEXT)"_s);
+            AVERIFY(result);
+
+            QList<QVariantList> rows;
+            for (int i = 0; i < 1000; ++i) {
+                rows.append({i, u"name %1"_s.arg(i)});
+            }
+
+            result = co_await db.execBatch(u"INSERT INTO batch VALUES (?, ?)"_s, rows);
+            AVERIFY(result);
+            ACOMPARE_EQ(result->numRowsAffected(), 1000);
+
+            // The duplicated id fails the third row and rolls back the whole batch
+            result = co_await db.execBatch(u"INSERT INTO batch VALUES (?, ?)"_s,
+                                           {{1000, u"a"_s}, {1001, u"b"_s}, {0, u"c"_s}});
+            AVERIFY(!result);
+            AVERIFY(result.error().contains(u"row 2"));
+
+            result = co_await db.exec(u"SELECT count(*) FROM batch"_s, QVariantList{});
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 1000);
+
+            // Inside a transaction the batch is undone without ending it
+            auto transaction = co_await db.begin();
+            AVERIFY(transaction);
+
+            result = co_await db.exec(u"DELETE FROM batch WHERE id >= 500"_s);
+            AVERIFY(result);
+
+            result = co_await db.execBatch(u"UPDATE batch SET name = ? WHERE id = ?"_s,
+                                           {{u"x"_s, 1}, {QVariant{}, 2}, {u"y"_s, 600}});
+            AVERIFY(result);
+            ACOMPARE_EQ(result->numRowsAffected(), 2);
+
+            result = co_await db.execBatch(u"INSERT INTO batch VALUES (?, ?)"_s,
+                                           {{500, u"a"_s}, {1, u"b"_s}});
+            AVERIFY(!result);
+
+            result = co_await transaction->commit();
+            AVERIFY(result);
+
+            result = co_await db.exec(
+                u"SELECT count(*), count(name), max(id) FROM batch"_s, QVariantList{});
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 500);
+            ACOMPARE_EQ((*result)[0][1].toInt(), 499);
+            ACOMPARE_EQ((*result)[0][2].toInt(), 499);
+        };
+        execBatch(finished);
+    }
+    loop.exec();
+}
+
+void TestSqlite::testQueryCancellation()
+{
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto queryCancellation = [](std::shared_ptr<QObject> finished) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "queryCancellation exited" << finished.use_count(); });
+
+            // Takes many seconds to finish if it's not interrupted
+            const auto longQuery = u"WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 "
+                                   u"FROM n WHERE i < 100000000) SELECT count(*) FROM n"_s;
+
+            ADatabase db{ASqlite::factory(u"sqlite://?MEMORY&QUERY_TIMEOUT=200"_s)};
+            auto opened = co_await db.coOpen();
+            AVERIFY(opened);
+
+            QElapsedTimer timer;
+            timer.start();
+            auto result = co_await db.exec(longQuery);
+            AVERIFY(!result);
+            AVERIFY(result.error().contains(u"timed out"));
+            AVERIFY(timer.elapsed() < 3000);
+
+            // The deadline is per query
+            result = co_await db.exec(u"SELECT 1"_s);
+            AVERIFY(result);
+
+            // Destroying the receiver frees the connection for the next query
+            ADatabase other{ASqlite::factory(u"sqlite://?MEMORY"_s)};
+            opened = co_await other.coOpen();
+            AVERIFY(opened);
+
+            auto receiver = new QObject;
+            QTimer::singleShot(100ms, receiver, &QObject::deleteLater);
+
+            timer.restart();
+            result = co_await other.exec(longQuery, receiver);
+            AVERIFY(!result);
+
+            result = co_await other.exec(u"SELECT 1"_s);
+            AVERIFY(result);
+            AVERIFY(timer.elapsed() < 3000);
+        };
+        queryCancellation(finished);
+    }
+    loop.exec();
+}
+
+void TestSqlite::testBusyTimeout()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QString path = dir.filePath(u"busy.db"_s);
+    auto factory       = [&path](const QString &query) {
+        QUrl url = QUrl::fromLocalFile(path);
+        url.setScheme(u"sqlite"_s);
+        url.setQuery(query);
+        return ASqlite::factory(url);
+    };
+
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto busyTimeout = [](std::shared_ptr<QObject> finished,
+                              std::shared_ptr<ADriverFactory> writerFactory,
+                              std::shared_ptr<ADriverFactory> budgetFactory,
+                              std::shared_ptr<ADriverFactory> retriesFactory) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "busyTimeout exited" << finished.use_count(); });
+
+            ADatabase writer{writerFactory};
+            auto opened = co_await writer.coOpen();
+            AVERIFY(opened);
+
+            ADatabase budget{budgetFactory};
+            opened = co_await budget.coOpen();
+            AVERIFY(opened);
+
+            ADatabase retries{retriesFactory};
+            opened = co_await retries.coOpen();
+            AVERIFY(opened);
+
+            auto result = co_await writer.exec(u"CREATE TABLE busy (id INTEGER)"_s);
+            AVERIFY(result);
+
+            // Holds the write lock until the COMMIT
+            result = co_await writer.exec(u"BEGIN IMMEDIATE"_s);
+            AVERIFY(result);
+
+            // Backs off until the BUSY_TIMEOUT budget passes, not the 5s default
+            QElapsedTimer timer;
+            timer.start();
+            result = co_await budget.exec(u"INSERT INTO busy VALUES (?)"_s, {1});
+            AVERIFY(!result);
+            AVERIFY(result.error().contains(u"locked"));
+            ACOMPARE_GE(timer.elapsed(), 250);
+            ACOMPARE_LT(timer.elapsed(), 3000);
+
+            // BUSY_RETRIES gives up long before its 5s budget
+            timer.restart();
+            result = co_await retries.exec(u"INSERT INTO busy VALUES (?)"_s, {2});
+            AVERIFY(!result);
+            AVERIFY(result.error().contains(u"locked"));
+            ACOMPARE_LT(timer.elapsed(), 1000);
+
+            // A write waiting for the lock succeeds once the writer commits
+            ADatabase waiter{writerFactory};
+            opened = co_await waiter.coOpen();
+            AVERIFY(opened);
+
+            auto waiting = waiter.exec(u"INSERT INTO busy VALUES (?)"_s, {3});
+
+            result = co_await writer.exec(u"COMMIT"_s);
+            AVERIFY(result);
+
+            result = co_await waiting;
+            AVERIFY(result);
+
+            result = co_await writer.exec(u"SELECT id FROM busy"_s, QVariantList{});
+            AVERIFY(result);
+            ACOMPARE_EQ(result->size(), 1);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 3);
+        };
+        busyTimeout(finished,
+                    factory({}),
+                    factory(u"BUSY_TIMEOUT=300"_s),
+                    factory(u"BUSY_RETRIES=2&BUSY_TIMEOUT=5000"_s));
+    }
+    loop.exec();
+}
+
 QTEST_MAIN(TestSqlite)
 #include "sqlite_tst.moc"
 
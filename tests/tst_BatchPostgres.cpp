@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2025 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+#include "CoverageObject.hpp"
+#include "acoroexpected.h"
+#include "adatabase.h"
+#include "apg.h"
+
+#include <QEventLoop>
+#include <QTest>
+
+using namespace ASql;
+using namespace Qt::Literals::StringLiterals;
+
+class TestBatchPostgres : public CoverageObject
+{
+    Q_OBJECT
+public:
+    void initTest() override;
+
+private Q_SLOTS:
+    void testExecBatch();
+};
+
+void TestBatchPostgres::initTest()
+{
+    if (!qEnvironmentVariableIsSet("ASQL_PG_TEST_DB")) {
+        QSKIP("ASQL_PG_TEST_DB not set; skipping Postgres batch tests");
+    }
+}
+
+void TestBatchPostgres::testExecBatch()
+{
+    QEventLoop loop;
+    {
+        auto finished = std::make_shared<QObject>();
+        connect(finished.get(), &QObject::destroyed, &loop, &QEventLoop::quit);
+
+        auto execBatch = [](std::shared_ptr<QObject> finished) -> ACoroTerminator {
+            auto _ = qScopeGuard(
+                [finished] { qDebug() << "execBatch exited" << finished.use_count(); });
+
+            ADatabase db = APg::database(qEnvironmentVariable("ASQL_PG_TEST_DB"));
+            auto opened  = co_await db.coOpen();
+            AVERIFY(opened);
+
+            auto result =
+                co_await db.exec(u8"CREATE TEMP TABLE batch (id integer PRIMARY KEY, name text)");
+            AVERIFY(result);
+
+            QList<QVariantList> rows;
+            for (int i = 0; i < 100; ++i) {
+                rows.append({i, u"name %1"_s.arg(i)});
+            }
+
+            // Outside a transaction the batch runs between BEGIN and COMMIT
+            result = co_await db.execBatch(u"INSERT INTO batch VALUES ($1, $2)"_s, rows);
+            AVERIFY(result);
+            ACOMPARE_EQ(result->numRowsAffected(), 100);
+
+            // The duplicated id fails the third row and rolls back the whole batch
+            result = co_await db.execBatch(u"INSERT INTO batch VALUES ($1, $2)"_s,
+                                           {{100, u"a"_s}, {101, u"b"_s}, {0, u"c"_s}});
+            AVERIFY(!result);
+            AVERIFY(result.error().contains(u"row 2"));
+
+            result = co_await db.exec(u8"SELECT count(*) FROM batch");
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 100);
+
+            // Inside a transaction only the savepoint is rolled back
+            auto transaction = co_await db.begin();
+            AVERIFY(transaction);
+
+            result = co_await db.exec(u8"DELETE FROM batch WHERE id >= 50");
+            AVERIFY(result);
+
+            result = co_await db.execBatch(u"UPDATE batch SET name = $1 WHERE id = $2"_s,
+                                           {{u"x"_s, 1}, {QVariant{}, 2}, {u"y"_s, 60}});
+            AVERIFY(result);
+            ACOMPARE_EQ(result->numRowsAffected(), 2);
+
+            result = co_await db.execBatch(u"INSERT INTO batch VALUES ($1, $2)"_s,
+                                           {{50, u"a"_s}, {1, u"b"_s}});
+            AVERIFY(!result);
+            AVERIFY(result.error().contains(u"row 1"));
+
+            result = co_await transaction->commit();
+            AVERIFY(result);
+
+            result = co_await db.exec(u8"SELECT count(*), count(name), max(id) FROM batch");
+            AVERIFY(result);
+            ACOMPARE_EQ((*result)[0][0].toInt(), 50);
+            ACOMPARE_EQ((*result)[0][1].toInt(), 49);
+            ACOMPARE_EQ((*result)[0][2].toInt(), 49);
+        };
+        execBatch(finished);
+    }
+    loop.exec();
+}
+
+QTEST_MAIN(TestBatchPostgres)
+#include "tst_BatchPostgres.moc"
@@ -0,0 +1,139 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2025 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "acolumnardata.h"
+
+#include <QObject>
+#include <QTest>
+
+using namespace ASql;
+using namespace Qt::Literals::StringLiterals;
+
+class TestColumnarData : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void typedColumns();
+    void nulls();
+    void doubleToInteger();
+    void mixedTypes();
+};
+
+void TestColumnarData::typedColumns()
+{
+    AColumnarData data;
+    data.reset(5);
+    for (int row = 0; row < 3; ++row) {
+        data.appendInt(row, QMetaType::fromType<int>());
+        data.appendDouble(row + 0.5);
+        data.appendText(u"ação %1"_s.arg(row).toUtf8());
+        data.appendDate(QDate(2024, 2, 29).addDays(row));
+        data.appendTime(QTime(13, 45, row));
+    }
+    data.squeeze();
+
+    QCOMPARE(data.rows(), 3);
+    QCOMPARE(data.columns(), 5);
+    QCOMPARE(data.columnType(0), QMetaType::fromType<int>());
+    QCOMPARE(data.columnType(2), QMetaType::fromType<QString>());
+
+    QCOMPARE(data.value(1, 0).metaType(), QMetaType::fromType<int>());
+    QCOMPARE(data.value(1, 0).toInt(), 1);
+    QCOMPARE(data.toDouble(2, 1), 2.5);
+    QCOMPARE(data.toString(1, 2), u"ação 1"_s);
+    QCOMPARE(data.toByteArray(1, 2), u"ação 1"_s.toUtf8());
+    QCOMPARE(data.toDate(2, 3), QDate(2024, 3, 2));
+    QCOMPARE(data.value(2, 4).toTime(), QTime(13, 45, 2));
+
+    std::vector<QString> strings(3);
+    QVERIFY(data.columnInto(2, std::span<QString>(strings), {}));
+    QCOMPARE(strings[2], u"ação 2"_s);
+}
+
+void TestColumnarData::nulls()
+{
+    AColumnarData data;
+    data.reset(1);
+
+    // Rows before the first value get their NULL bit once the column has a type
+    for (int row = 0; row < 70; ++row) {
+        if (row % 3) {
+            data.appendInt(row);
+        } else {
+            data.appendNull(QMetaType::fromType<qint64>());
+        }
+    }
+
+    std::vector<qint64> out(70);
+    std::vector<quint64> nullBits(2);
+    QVERIFY(data.columnInto(0, std::span<qint64>(out), std::span<quint64>(nullBits)));
+    for (int row = 0; row < 70; ++row) {
+        const bool null = row % 3 == 0;
+        QCOMPARE(data.isNull(row, 0), null);
+        QCOMPARE(bool((nullBits[row >> 6] >> (row & 63)) & 1), null);
+        QCOMPARE(out[row], qint64(null ? 0 : row));
+    }
+    QCOMPARE(data.value(0, 0).metaType(), QMetaType::fromType<qint64>());
+    QVERIFY(data.value(0, 0).isNull());
+}
+
+void TestColumnarData::doubleToInteger()
+{
+    AColumnarData data;
+    data.reset(1);
+    data.appendDouble(2.7);
+    data.appendDouble(-2.7);
+    data.appendDouble(2.2);
+
+    // Rounded like QVariant::toLongLong() does
+    for (int row = 0; row < data.rows(); ++row) {
+        QCOMPARE(data.toLongLong(row, 0), data.value(row, 0).toLongLong());
+    }
+    QCOMPARE(data.toLongLong(0, 0), qint64(3));
+    QCOMPARE(data.toULongLong(0, 0), quint64(3));
+
+    std::vector<int> ints(3);
+    QVERIFY(data.columnInto(0, std::span<int>(ints), {}));
+    QCOMPARE(ints, (std::vector<int>{3, -3, 2}));
+}
+
+void TestColumnarData::mixedTypes()
+{
+    AColumnarData data;
+    data.reset(2);
+
+    // SQLite allows any type on any row, the column falls back to QVariant
+    data.appendNull(QMetaType::fromType<QString>());
+    data.appendText("a");
+    data.appendInt(1);
+    data.appendText("b");
+    data.appendText("2");
+    data.appendBytes("c");
+    data.append(QVariant(2.5));
+    data.append(QVariant());
+
+    QCOMPARE(data.rows(), 4);
+    QVERIFY(!data.columnType(0).isValid());
+    QVERIFY(!data.columnType(1).isValid());
+
+    QVERIFY(data.isNull(0, 0));
+    QCOMPARE(data.value(1, 0).metaType(), QMetaType::fromType<qint64>());
+    QCOMPARE(data.toLongLong(1, 0), qint64(1));
+    QCOMPARE(data.value(2, 0).metaType(), QMetaType::fromType<QString>());
+    QCOMPARE(data.toString(2, 0), u"2"_s);
+    QCOMPARE(data.toDouble(3, 0), 2.5);
+    QCOMPARE(data.toLongLong(3, 0), qint64(3));
+
+    QCOMPARE(data.value(0, 1).metaType(), QMetaType::fromType<QString>());
+    QCOMPARE(data.value(2, 1).metaType(), QMetaType::fromType<QByteArray>());
+    QVERIFY(data.isNull(3, 1));
+
+    // Typed extraction is refused, results fall back to the per cell conversion
+    std::vector<qint64> out(4);
+    QVERIFY(!data.columnInto(0, std::span<qint64>(out), {}));
+}
+
+QTEST_MAIN(TestColumnarData)
+#include "tst_ColumnarData.moc"
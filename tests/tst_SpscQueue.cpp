@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2025 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "aspscqueue.h"
+
+#include <QObject>
+#include <QTest>
+#include <QThread>
+
+using namespace ASql;
+using namespace Qt::Literals::StringLiterals;
+
+class TestSpscQueue : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void singleThread();
+    void producerThread();
+};
+
+void TestSpscQueue::singleThread()
+{
+    ASpscQueue<QString, 4> queue;
+    QVERIFY(!queue.pop());
+
+    // Only the first push wakes the consumer up
+    QVERIFY(queue.push(u"0"_s));
+    for (int i = 1; i < 10; ++i) {
+        QVERIFY(!queue.push(QString::number(i)));
+    }
+
+    queue.wakeupReceived();
+    for (int i = 0; i < 10; ++i) {
+        const auto item = queue.pop();
+        QVERIFY(item);
+        QCOMPARE(*item, QString::number(i));
+    }
+    QVERIFY(!queue.pop());
+
+    QVERIFY(queue.push(u"10"_s));
+}
+
+void TestSpscQueue::producerThread()
+{
+    constexpr int count = 100'000;
+
+    ASpscQueue<int> queue;
+    std::atomic_int wakeups = 0;
+    auto producer           = QThread::create([&] {
+        for (int i = 0; i < count; ++i) {
+            if (queue.push(i)) {
+                ++wakeups;
+            }
+        }
+    });
+    producer->start();
+
+    int next = 0;
+    while (next < count) {
+        queue.wakeupReceived();
+        while (auto item = queue.pop()) {
+            QCOMPARE(*item, next++);
+        }
+    }
+
+    producer->wait();
+    delete producer;
+    QVERIFY(wakeups > 0);
+    QVERIFY(wakeups <= count);
+}
+
+QTEST_MAIN(TestSpscQueue)
+#include "tst_SpscQueue.moc"